@@ -0,0 +1,125 @@
+/*
+ * animation.c
+ *
+ * Author: Arjun Srikanth
+ *
+ * Each queued step is packed into a single byte to keep the queue small:
+ * bits 0-2 hold x, bits 3-6 hold y and bit 7 is set if the step belongs
+ * to player 1.
+ */
+
+#include "animation.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include "display.h"
+
+#define STEP_PLAYER_1	0x80
+#define STEP_X(step)	((step) & 0x07)
+#define STEP_Y(step)	(((step) >> 3) & 0x0F)
+
+// Circular queue of steps. step_head is the next step to show and
+// step_count is the number of steps waiting.
+static uint8_t step_queue[ANIMATION_QUEUE_SIZE];
+static uint8_t step_head;
+static uint8_t step_count;
+
+// Number of steps waiting for each player (index 0 is player 1)
+static uint8_t player_steps[2];
+
+// Time the last step was shown
+static uint32_t last_step_time;
+
+// Square each player's token is heading for (packed like a step, without
+// the player bit), if it is highlighted
+static uint8_t targets[2];
+static bool target_shown[2];
+
+// Remove the highlight of the player's target square, unless the other
+// player is heading for the same square
+static void hide_target(uint8_t player) {
+	if (!target_shown[player]) {
+		return;
+	}
+	target_shown[player] = false;
+	if (!target_shown[!player] || targets[!player] != targets[player]) {
+		display_clear_overlay(STEP_X(targets[player]), STEP_Y(targets[player]));
+	}
+}
+
+static void show_target(uint8_t player, uint8_t target) {
+	hide_target(player);
+	targets[player] = target;
+	target_shown[player] = true;
+	display_set_overlay(STEP_X(target), STEP_Y(target), MATRIX_COLOUR_TARGET);
+}
+
+void animation_init(void) {
+	hide_target(0);
+	hide_target(1);
+	step_head = 0;
+	step_count = 0;
+	player_steps[0] = 0;
+	player_steps[1] = 0;
+	last_step_time = 0;
+}
+
+// Take the next step off the queue and move its token there
+static void show_next_step(void) {
+	uint8_t step = step_queue[step_head];
+	step_head = (step_head + 1) & (ANIMATION_QUEUE_SIZE - 1);
+	step_count--;
+
+	uint8_t player = (step & STEP_PLAYER_1) ? 0 : 1;
+	player_steps[player]--;
+	if (player_steps[player] == 0) {
+		hide_target(player);
+	}
+
+	// Move the token layer - the old square is recomposed from the board
+	// (or the other token) on the next render
+	display_set_token(player == 0 ? DISPLAY_PLAYER_1 : DISPLAY_PLAYER_2,
+			STEP_X(step), STEP_Y(step));
+}
+
+void animation_queue_step(bool move_player_1, int8_t x, int8_t y) {
+	uint8_t step = ((uint8_t)y << 3) | (uint8_t)x;
+	if (move_player_1) {
+		step |= STEP_PLAYER_1;
+	}
+
+	if (step_count == ANIMATION_QUEUE_SIZE) {
+		// Queue is full - show the oldest step now to make room, so no
+		// step (of either player) is lost and both tokens still end up
+		// in the right place
+		show_next_step();
+	}
+	step_queue[(step_head + step_count) & (ANIMATION_QUEUE_SIZE - 1)] = step;
+	step_count++;
+	uint8_t player = move_player_1 ? 0 : 1;
+	player_steps[player]++;
+	if (player_steps[player] > 1) {
+		show_target(player, step & ~STEP_PLAYER_1);
+	}
+}
+
+void animation_update(uint32_t current_time) {
+	if (step_count == 0 || current_time - last_step_time < ANIMATION_STEP_MS) {
+		return;
+	}
+	show_next_step();
+	last_step_time = current_time;
+}
+
+void animation_skip(void) {
+	while (step_count) {
+		show_next_step();
+	}
+}
+
+bool animation_in_progress(void) {
+	return step_count != 0;
+}
+
+bool animation_player_busy(bool move_player_1) {
+	return player_steps[move_player_1 ? 0 : 1] != 0;
+}
@@ -0,0 +1,52 @@
+/*
+ * animation.h
+ *
+ * Author: Arjun Srikanth
+ *
+ * Non-blocking animation of the player tokens. Moves are broken up into
+ * single square steps which are placed in a queue. The queue is worked
+ * through one step every ANIMATION_STEP_MS by animation_update(), which
+ * should be called from the main game loop with the current time (see
+ * timer0.h) and moves the token layer of the display (see display.h).
+ * Nothing here ever waits, so input and timers keep running while a token
+ * is walking or sliding down a snake. While a token has more than one step
+ * to go, the square it will finish on is highlighted with an overlay.
+ */
+
+
+#ifndef ANIMATION_H_
+#define ANIMATION_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Time (in milliseconds) each step of an animation is shown for
+#define ANIMATION_STEP_MS 100
+
+// Maximum number of steps waiting to be shown. Must be a power of two.
+#define ANIMATION_QUEUE_SIZE 16
+
+// Empty the queue. Called when a new game is initialised.
+void animation_init(void);
+
+// Add a step to the queue - the token of the given player will be moved
+// to square (x, y) when the step is reached. If the queue is full the
+// oldest step is shown straight away to make room, so both tokens always
+// finish on their final squares.
+void animation_queue_step(bool move_player_1, int8_t x, int8_t y);
+
+// Show the next queued step if ANIMATION_STEP_MS has passed since the
+// last step was shown.
+void animation_update(uint32_t current_time);
+
+// Show all the queued steps at once, leaving the tokens on their final
+// squares. Used when moves are made faster than they can be animated.
+void animation_skip(void);
+
+// Returns true if there are steps waiting to be shown.
+bool animation_in_progress(void);
+
+// Returns true if there are steps waiting to be shown for the given player.
+bool animation_player_busy(bool move_player_1);
+
+#endif /* ANIMATION_H_ */
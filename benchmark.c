@@ -0,0 +1,99 @@
+/*
+ * benchmark.c
+ *
+ * Author: Arjun Srikanth
+ */
+
+#include "benchmark.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <avr/pgmspace.h>
+#include <avr/wdt.h>
+#include "serialio.h"
+#include "terminalio.h"
+#include "timer0.h"
+#include "buttons.h"
+
+// Characters in each line of benchmark text (including \r\n)
+#define LINE_LENGTH 64
+
+void print_baud_rate(void) {
+	int16_t error = serial_get_baud_error();
+	char sign = '+';
+	if (error < 0) {
+		sign = '-';
+		error = -error;
+	}
+	printf_P(PSTR("Serial: %ld baud (error %c%d.%d%%)"), serial_get_baud(),
+			sign, error / 10, error % 10);
+}
+
+void run_serial_benchmark(void) {
+	char line[LINE_LENGTH];
+	for (uint8_t i = 0; i < LINE_LENGTH - 2; i++) {
+		line[i] = 'A' + (i % 26);
+	}
+	line[LINE_LENGTH - 2] = '\r';
+	line[LINE_LENGTH - 1] = '\n';
+
+	clear_terminal();
+	normal_display_mode();
+
+	// Keep the output buffer full for BENCHMARK_MS. A line is only written
+	// when it fits, so the loop never waits inside serial_write() and can
+	// record how many characters are waiting once every tick - sampling
+	// after each write would only ever see the buffer just filled.
+	uint32_t bytes = 0;
+	uint32_t occupancy_total = 0;
+	uint16_t samples = 0;
+	uint8_t occupancy_min = 0xFF;
+	uint8_t occupancy_max = 0;
+	uint32_t start_time = get_current_time();
+	uint32_t sample_time = start_time;
+	uint32_t current_time = start_time;
+	while (current_time - start_time < BENCHMARK_MS) {
+		if (serial_output_space() >= LINE_LENGTH) {
+			bytes += serial_write(line, LINE_LENGTH);
+		}
+		current_time = get_current_time();
+		if (current_time != sample_time) {
+			sample_time = current_time;
+			uint8_t occupancy = serial_output_pending();
+			occupancy_total += occupancy;
+			samples++;
+			if (occupancy < occupancy_min) {
+				occupancy_min = occupancy;
+			}
+			if (occupancy > occupancy_max) {
+				occupancy_max = occupancy;
+			}
+			wdt_reset();
+		}
+	}
+	// Everything written has been sent once the buffer is empty
+	while (serial_output_pending()) {
+		; // wait
+	}
+	uint32_t elapsed = get_current_time() - start_time;
+
+	clear_terminal();
+	move_terminal_cursor(10, 10);
+	printf_P(PSTR("Serial benchmark: %lu characters in %lu ms"), bytes, elapsed);
+	move_terminal_cursor(10, 12);
+	// Each character is 10 bits on the line (start, 8 data, stop)
+	printf_P(PSTR("Throughput: %lu characters/s (line rate %lu characters/s)"),
+			(bytes * 1000) / elapsed, serial_get_baud() / 10);
+	move_terminal_cursor(10, 13);
+	// The buffer is empty now, so all of it is free
+	printf_P(PSTR("Output buffer: %u to %u of %u characters waiting (average %lu)"),
+			occupancy_min, occupancy_max, serial_output_space(),
+			occupancy_total / samples);
+	move_terminal_cursor(10, 14);
+	print_baud_rate();
+	move_terminal_cursor(10, 16);
+	printf_P(PSTR("Press a key or button to return"));
+
+	// Keys typed and buttons pushed while the benchmark ran don't count
+	clear_serial_input_buffer();
+	clear_button_pushes();
+}
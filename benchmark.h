@@ -0,0 +1,27 @@
+/*
+ * benchmark.h
+ *
+ * Author: Arjun Srikanth
+ *
+ * Serial port throughput benchmark, run from the start screen. The
+ * terminal is filled with text for BENCHMARK_MS and then the results are
+ * shown: the rate characters were actually sent compared with the line
+ * rate for the baud rate, and how full the output buffer was (sampled
+ * every millisecond).
+ */
+
+
+#ifndef BENCHMARK_H_
+#define BENCHMARK_H_
+
+#define BENCHMARK_MS 2000
+
+// Print the baud rate in use and its error at the current cursor position
+void print_baud_rate(void);
+
+// Run the benchmark and show the results, with a prompt to press a key or
+// button to return - the caller waits for that (as the start screen does
+// for its other pages).
+void run_serial_benchmark(void);
+
+#endif /* BENCHMARK_H_ */
@@ -0,0 +1,358 @@
+/*
+ * board_library.c
+ *
+ * Author: Arjun Srikanth
+ *
+ * Every board has its start at (0, 0) and its finish at (0, HEIGHT - 1),
+ * so only the snakes and ladders are stored. Each one is two bytes: the
+ * square it starts on and the square it ends on (x in bits 0-3, y in bits
+ * 4-7, as for stored boards - see boards.h). A link which goes down is a
+ * snake and one which goes up is a ladder. Snakes and ladders are given
+ * identifiers in the order they are listed, and the squares in between
+ * are filled in when the board is decoded, so they must go straight up or
+ * down, or diagonally. A board is ended by END_OF_BOARD, which can't be
+ * mistaken for a link as nothing starts on the start square.
+ */
+
+#include "board_library.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <avr/pgmspace.h>
+
+#define LINK(start_x, start_y, end_x, end_y) \
+	(((start_y) << 4) | (start_x)), (((end_y) << 4) | (end_x))
+#define END_OF_BOARD 0
+
+static const uint8_t board_1[] PROGMEM = {
+	LINK(3, 4, 3, 0),
+	LINK(0, 9, 2, 7),
+	LINK(6, 11, 6, 8),
+	LINK(1, 14, 1, 11),
+	LINK(5, 2, 7, 4),
+	LINK(1, 1, 1, 3),
+	LINK(4, 8, 4, 10),
+	LINK(2, 12, 4, 14),
+	END_OF_BOARD
+};
+
+static const uint8_t board_2[] PROGMEM = {
+	LINK(1, 4, 5, 0),
+	LINK(1, 7, 1, 6),
+	LINK(4, 8, 6, 6),
+	LINK(3, 12, 3, 10),
+	LINK(1, 15, 1, 11),
+	LINK(1, 0, 1, 3),
+	LINK(7, 4, 7, 6),
+	LINK(6, 9, 4, 11),
+	LINK(2, 12, 5, 15),
+	END_OF_BOARD
+};
+
+static const uint8_t board_3[] PROGMEM = {
+	LINK(3, 10, 7, 6),
+	LINK(2, 6, 0, 4),
+	LINK(6, 4, 6, 1),
+	LINK(7, 14, 7, 12),
+	LINK(4, 13, 4, 11),
+	LINK(5, 4, 5, 6),
+	LINK(4, 4, 4, 6),
+	LINK(2, 7, 2, 11),
+	END_OF_BOARD
+};
+
+static const uint8_t board_4[] PROGMEM = {
+	LINK(3, 10, 3, 8),
+	LINK(0, 11, 0, 6),
+	LINK(3, 7, 3, 3),
+	LINK(7, 6, 7, 1),
+	LINK(6, 10, 4, 12),
+	LINK(7, 7, 4, 10),
+	LINK(5, 5, 5, 7),
+	LINK(6, 3, 4, 5),
+	LINK(1, 3, 1, 7),
+	END_OF_BOARD
+};
+
+static const uint8_t board_5[] PROGMEM = {
+	LINK(0, 9, 0, 4),
+	LINK(1, 5, 1, 2),
+	LINK(7, 5, 3, 1),
+	LINK(2, 4, 2, 8),
+	LINK(6, 5, 6, 11),
+	LINK(5, 10, 1, 14),
+	LINK(3, 6, 3, 11),
+	END_OF_BOARD
+};
+
+static const uint8_t board_6[] PROGMEM = {
+	LINK(2, 8, 2, 2),
+	LINK(1, 13, 1, 10),
+	LINK(4, 14, 6, 12),
+	LINK(5, 3, 5, 8),
+	LINK(7, 6, 7, 9),
+	LINK(2, 9, 6, 13),
+	END_OF_BOARD
+};
+
+static const uint8_t board_7[] PROGMEM = {
+	LINK(0, 12, 0, 6),
+	LINK(6, 14, 6, 8),
+	LINK(7, 8, 1, 2),
+	LINK(7, 5, 5, 3),
+	LINK(1, 11, 1, 7),
+	LINK(2, 10, 2, 14),
+	LINK(5, 9, 5, 14),
+	LINK(4, 9, 4, 14),
+	LINK(4, 3, 7, 6),
+	LINK(1, 1, 7, 7),
+	END_OF_BOARD
+};
+
+static const uint8_t board_8[] PROGMEM = {
+	LINK(3, 4, 1, 2),
+	LINK(4, 14, 4, 12),
+	LINK(4, 8, 4, 6),
+	LINK(3, 12, 3, 6),
+	LINK(6, 9, 6, 12),
+	LINK(5, 11, 5, 14),
+	LINK(7, 3, 7, 8),
+	END_OF_BOARD
+};
+
+static const uint8_t board_9[] PROGMEM = {
+	LINK(1, 8, 7, 2),
+	LINK(5, 11, 3, 9),
+	LINK(6, 9, 6, 6),
+	LINK(3, 12, 5, 10),
+	LINK(4, 4, 1, 7),
+	LINK(1, 9, 1, 14),
+	LINK(6, 10, 6, 13),
+	END_OF_BOARD
+};
+
+static const uint8_t board_10[] PROGMEM = {
+	LINK(4, 6, 4, 4),
+	LINK(4, 11, 0, 7),
+	LINK(3, 11, 1, 9),
+	LINK(7, 11, 7, 5),
+	LINK(6, 6, 6, 10),
+	LINK(5, 8, 5, 14),
+	LINK(2, 1, 2, 7),
+	END_OF_BOARD
+};
+
+static const uint8_t board_11[] PROGMEM = {
+	LINK(7, 13, 1, 7),
+	LINK(5, 8, 5, 4),
+	LINK(0, 10, 0, 5),
+	LINK(1, 6, 1, 3),
+	LINK(6, 5, 6, 11),
+	LINK(2, 2, 2, 7),
+	LINK(1, 9, 1, 14),
+	END_OF_BOARD
+};
+
+static const uint8_t board_12[] PROGMEM = {
+	LINK(5, 13, 5, 7),
+	LINK(4, 13, 4, 7),
+	LINK(7, 11, 7, 5),
+	LINK(4, 4, 6, 6),
+	LINK(0, 5, 0, 11),
+	LINK(2, 1, 2, 5),
+	LINK(1, 7, 1, 10),
+	LINK(5, 4, 2, 7),
+	END_OF_BOARD
+};
+
+static const uint8_t board_13[] PROGMEM = {
+	LINK(7, 11, 1, 5),
+	LINK(3, 14, 3, 9),
+	LINK(1, 8, 1, 6),
+	LINK(1, 11, 1, 9),
+	LINK(4, 3, 7, 6),
+	LINK(0, 3, 0, 7),
+	LINK(5, 11, 5, 14),
+	LINK(4, 9, 4, 14),
+	LINK(6, 12, 6, 14),
+	END_OF_BOARD
+};
+
+static const uint8_t board_14[] PROGMEM = {
+	LINK(5, 5, 5, 1),
+	LINK(5, 9, 5, 6),
+	LINK(1, 6, 3, 4),
+	LINK(1, 9, 4, 12),
+	LINK(7, 5, 7, 11),
+	LINK(1, 8, 5, 12),
+	END_OF_BOARD
+};
+
+static const uint8_t board_15[] PROGMEM = {
+	LINK(2, 3, 2, 1),
+	LINK(7, 5, 3, 1),
+	LINK(1, 8, 1, 2),
+	LINK(5, 14, 5, 11),
+	LINK(6, 10, 6, 13),
+	LINK(3, 3, 3, 5),
+	LINK(2, 5, 7, 10),
+	LINK(3, 8, 3, 11),
+	END_OF_BOARD
+};
+
+static const uint8_t board_16[] PROGMEM = {
+	LINK(3, 6, 3, 2),
+	LINK(7, 12, 7, 8),
+	LINK(2, 9, 2, 6),
+	LINK(7, 6, 5, 8),
+	LINK(5, 3, 5, 7),
+	LINK(1, 3, 1, 8),
+	END_OF_BOARD
+};
+
+static const uint8_t board_17[] PROGMEM = {
+	LINK(7, 4, 7, 2),
+	LINK(3, 7, 3, 4),
+	LINK(1, 4, 1, 1),
+	LINK(1, 5, 1, 10),
+	LINK(6, 1, 6, 4),
+	LINK(6, 7, 6, 10),
+	LINK(5, 3, 5, 7),
+	END_OF_BOARD
+};
+
+static const uint8_t board_18[] PROGMEM = {
+	LINK(6, 10, 6, 4),
+	LINK(0, 6, 0, 2),
+	LINK(7, 9, 7, 5),
+	LINK(5, 13, 5, 11),
+	LINK(4, 8, 4, 14),
+	LINK(3, 8, 3, 13),
+	LINK(3, 2, 1, 4),
+	LINK(1, 11, 1, 13),
+	END_OF_BOARD
+};
+
+static const uint8_t board_19[] PROGMEM = {
+	LINK(7, 4, 7, 2),
+	LINK(1, 10, 5, 6),
+	LINK(2, 13, 2, 11),
+	LINK(0, 7, 0, 12),
+	LINK(1, 3, 7, 9),
+	LINK(0, 4, 3, 7),
+	LINK(5, 1, 5, 4),
+	END_OF_BOARD
+};
+
+static const uint8_t board_20[] PROGMEM = {
+	LINK(6, 13, 0, 7),
+	LINK(2, 5, 5, 2),
+	LINK(4, 4, 1, 1),
+	LINK(6, 8, 6, 2),
+	LINK(0, 14, 0, 10),
+	LINK(0, 1, 2, 3),
+	LINK(3, 1, 5, 3),
+	LINK(5, 6, 5, 8),
+	LINK(6, 12, 4, 14),
+	END_OF_BOARD
+};
+
+static const uint8_t board_21[] PROGMEM = {
+	LINK(7, 9, 7, 6),
+	LINK(2, 7, 2, 2),
+	LINK(1, 9, 1, 7),
+	LINK(4, 7, 1, 10),
+	LINK(3, 2, 3, 7),
+	LINK(7, 1, 7, 4),
+	LINK(1, 3, 1, 6),
+	END_OF_BOARD
+};
+
+static const uint8_t board_22[] PROGMEM = {
+	LINK(6, 8, 6, 2),
+	LINK(6, 13, 6, 9),
+	LINK(0, 12, 0, 9),
+	LINK(5, 8, 5, 3),
+	LINK(4, 14, 4, 12),
+	LINK(3, 3, 3, 5),
+	LINK(1, 8, 1, 10),
+	LINK(0, 1, 0, 3),
+	LINK(2, 9, 2, 12),
+	LINK(7, 4, 7, 9),
+	END_OF_BOARD
+};
+
+static const uint8_t board_23[] PROGMEM = {
+	LINK(6, 5, 6, 2),
+	LINK(6, 14, 3, 11),
+	LINK(2, 6, 2, 1),
+	LINK(5, 9, 5, 12),
+	LINK(7, 2, 7, 8),
+	LINK(3, 5, 5, 7),
+	END_OF_BOARD
+};
+
+static const uint8_t board_24[] PROGMEM = {
+	LINK(5, 7, 3, 5),
+	LINK(0, 12, 0, 8),
+	LINK(1, 11, 1, 5),
+	LINK(1, 2, 6, 7),
+	LINK(6, 1, 6, 3),
+	LINK(7, 9, 2, 14),
+	LINK(5, 1, 5, 5),
+	END_OF_BOARD
+};
+static const uint8_t* const library[BOARD_LIBRARY_SIZE] PROGMEM = {
+	board_1, board_2, board_3, board_4, board_5, board_6,
+	board_7, board_8, board_9, board_10, board_11, board_12,
+	board_13, board_14, board_15, board_16, board_17, board_18,
+	board_19, board_20, board_21, board_22, board_23, board_24
+};
+
+// Put a snake or ladder on the board, including the squares in between
+static void place_link(uint8_t board[WIDTH][HEIGHT], uint8_t start, uint8_t end,
+		uint8_t object_start, uint8_t identifier) {
+	int8_t x = start & 0x0F;
+	int8_t y = start >> 4;
+	int8_t end_x = end & 0x0F;
+	int8_t end_y = end >> 4;
+	int8_t dx = (end_x > x) - (end_x < x);
+	int8_t dy = (end_y > y) - (end_y < y);
+
+	// The end and middle objects follow the start in game.h
+	board[x][y] = object_start | identifier;
+	board[end_x][end_y] = (object_start + 0x10) | identifier;
+	for (uint8_t i = abs(end_y - y) - 1; i > 0; i--) {
+		x += dx;
+		y += dy;
+		board[x][y] = object_start + 0x20;
+	}
+}
+
+bool board_library_load(uint8_t board_number, uint8_t board[WIDTH][HEIGHT]) {
+	if (board_number < 1 || board_number > BOARD_LIBRARY_SIZE) {
+		return false;
+	}
+	for (uint8_t x = 0; x < WIDTH; x++) {
+		for (uint8_t y = 0; y < HEIGHT; y++) {
+			board[x][y] = EMPTY_SQUARE;
+		}
+	}
+	board[0][0] = START_POINT;
+	board[0][HEIGHT - 1] = FINISH_LINE;
+
+	const uint8_t* links = pgm_read_ptr(&library[board_number - 1]);
+	uint8_t snakes = 0;
+	uint8_t ladders = 0;
+	uint8_t start;
+	while ((start = pgm_read_byte(links)) != END_OF_BOARD) {
+		uint8_t end = pgm_read_byte(links + 1);
+		links += 2;
+		if ((end >> 4) < (start >> 4)) {
+			place_link(board, start, end, SNAKE_START, ++snakes);
+		} else {
+			place_link(board, start, end, LADDER_START, ++ladders);
+		}
+	}
+	return true;
+}
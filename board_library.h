@@ -0,0 +1,26 @@
+/*
+ * board_library.h
+ *
+ * Author: Arjun Srikanth
+ *
+ * The boards built into the program. They are kept in program memory in a
+ * compact form and only decoded (straight into the game board) when a
+ * game starts, so more boards cost flash but no RAM.
+ */
+
+
+#ifndef BOARD_LIBRARY_H_
+#define BOARD_LIBRARY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "game.h"
+
+// Number of boards in the library - numbered from 1
+#define BOARD_LIBRARY_SIZE 24
+
+// Fill in the board with board board_number from the library. Returns
+// false (leaving the board unchanged) if there is no such board.
+bool board_library_load(uint8_t board_number, uint8_t board[WIDTH][HEIGHT]);
+
+#endif /* BOARD_LIBRARY_H_ */
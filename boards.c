@@ -0,0 +1,187 @@
+/*
+ * boards.c
+ *
+ * Author: Arjun Srikanth
+ *
+ * Uploaded entries are written straight into their slot in EEPROM (with
+ * the header marked empty), so no RAM is needed to hold a board while it
+ * arrives. The checks are then made on what was written.
+ */
+
+#include "boards.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include "frame.h"
+#include "storage.h"
+
+#define BOARD_MAGIC 0xB5
+
+// EEPROM layout of a slot: magic, number of entries, CRC (2 bytes), then
+// the entries
+#define SLOT_HEADER_SIZE 4
+#define SLOT_SIZE (BOARDS_EEPROM_SIZE / BOARD_SLOTS)
+#define SLOT_ADDRESS(slot) ((uint16_t) (slot) * SLOT_SIZE)
+#define ENTRY_ADDRESS(slot, entry) (SLOT_ADDRESS(slot) + SLOT_HEADER_SIZE + 2 * (entry))
+
+// Upload in progress
+static bool uploading;
+static uint8_t upload_slot;
+static uint8_t upload_entries;
+static uint8_t upload_received;	// bytes
+
+// CRC of the entries stored in a slot
+static uint16_t entries_crc(uint8_t slot, uint8_t num_entries) {
+	uint16_t crc = 0xFFFF;
+	uint16_t address = ENTRY_ADDRESS(slot, 0);
+	for (uint8_t i = 0; i < 2 * num_entries; i++) {
+		crc = frame_crc16_update(crc, storage_read_byte(address++));
+	}
+	return crc;
+}
+
+bool boards_slot_valid(uint8_t slot) {
+	if (slot >= BOARD_SLOTS || storage_read_byte(SLOT_ADDRESS(slot)) != BOARD_MAGIC) {
+		return false;
+	}
+	uint8_t num_entries = storage_read_byte(SLOT_ADDRESS(slot) + 1);
+	uint16_t crc = storage_read_word(SLOT_ADDRESS(slot) + 2);
+	return num_entries <= BOARD_MAX_ENTRIES && entries_crc(slot, num_entries) == crc;
+}
+
+bool boards_is_stored(uint8_t board_number) {
+	return board_number > BUILT_IN_BOARDS;
+}
+
+uint8_t boards_next(uint8_t board_number) {
+	while (board_number < BUILT_IN_BOARDS + BOARD_SLOTS) {
+		board_number++;
+		if (!boards_is_stored(board_number)
+				|| boards_slot_valid(board_number - BUILT_IN_BOARDS - 1)) {
+			return board_number;
+		}
+	}
+	return 1;
+}
+
+bool boards_load(uint8_t slot, uint8_t board[WIDTH][HEIGHT]) {
+	if (!boards_slot_valid(slot)) {
+		return false;
+	}
+	for (uint8_t x = 0; x < WIDTH; x++) {
+		for (uint8_t y = 0; y < HEIGHT; y++) {
+			board[x][y] = EMPTY_SQUARE;
+		}
+	}
+	uint8_t num_entries = storage_read_byte(SLOT_ADDRESS(slot) + 1);
+	for (uint8_t i = 0; i < num_entries; i++) {
+		uint8_t position = storage_read_byte(ENTRY_ADDRESS(slot, i));
+		board[position & 0x0F][position >> 4] = storage_read_byte(ENTRY_ADDRESS(slot, i) + 1);
+	}
+	return true;
+}
+
+BoardStatus boards_upload_start(uint8_t slot, uint8_t num_entries) {
+	uploading = false;
+	if (slot >= BOARD_SLOTS) {
+		return BOARD_BAD_SLOT;
+	}
+	if (num_entries > BOARD_MAX_ENTRIES) {
+		return BOARD_BAD_LENGTH;
+	}
+	storage_update_byte(SLOT_ADDRESS(slot), 0xFF);
+	uploading = true;
+	upload_slot = slot;
+	upload_entries = num_entries;
+	upload_received = 0;
+	return BOARD_OK;
+}
+
+BoardStatus boards_upload_data(const uint8_t* data, uint8_t length) {
+	if (!uploading) {
+		return BOARD_NOT_STARTED;
+	}
+	if (upload_received + length > 2 * upload_entries) {
+		uploading = false;
+		return BOARD_BAD_LENGTH;
+	}
+	storage_update_block(data, ENTRY_ADDRESS(upload_slot, 0) + upload_received, length);
+	upload_received += length;
+	return BOARD_OK;
+}
+
+// Check the entries of the board being uploaded make a playable board
+static BoardStatus check_board(void) {
+	uint8_t used[WIDTH * HEIGHT / 8];
+	for (uint8_t i = 0; i < sizeof(used); i++) {
+		used[i] = 0;
+	}
+	// Bit n is set if the snake or ladder with identifier n has a start
+	// (or end)
+	uint16_t starts[2] = {0, 0};
+	uint16_t ends[2] = {0, 0};
+	bool start_found = false;
+	bool finish_found = false;
+
+	for (uint8_t i = 0; i < upload_entries; i++) {
+		uint8_t position = storage_read_byte(ENTRY_ADDRESS(upload_slot, i));
+		uint8_t object = storage_read_byte(ENTRY_ADDRESS(upload_slot, i) + 1);
+		uint8_t x = position & 0x0F;
+		uint8_t y = position >> 4;
+		uint8_t square = y * WIDTH + x;
+		if (x >= WIDTH || (used[square >> 3] & (1 << (square & 7)))) {
+			return BOARD_BAD_SQUARE;
+		}
+		used[square >> 3] |= (1 << (square & 7));
+
+		uint8_t type = get_object_type(object);
+		uint16_t identifier = (1 << (object & 0x0F));
+		uint8_t ladder = (type >= LADDER_START) ? 1 : 0;
+		if (type == START_POINT) {
+			start_found = (x == 0 && y == 0);
+		} else if (type == FINISH_LINE) {
+			finish_found = (x == 0 && y == HEIGHT - 1);
+		} else if (type == SNAKE_START || type == LADDER_START) {
+			if (starts[ladder] & identifier) {
+				return BOARD_UNMATCHED;
+			}
+			starts[ladder] |= identifier;
+		} else if (type == SNAKE_END || type == LADDER_END) {
+			if (ends[ladder] & identifier) {
+				return BOARD_UNMATCHED;
+			}
+			ends[ladder] |= identifier;
+		} else if (type != SNAKE_MIDDLE && type != LADDER_MIDDLE) {
+			return BOARD_BAD_SQUARE;
+		}
+	}
+	if (!start_found || !finish_found) {
+		return BOARD_NO_START_FINISH;
+	}
+	if (starts[0] != ends[0] || starts[1] != ends[1]) {
+		return BOARD_UNMATCHED;
+	}
+	return BOARD_OK;
+}
+
+BoardStatus boards_upload_finish(uint16_t crc) {
+	if (!uploading) {
+		return BOARD_NOT_STARTED;
+	}
+	uploading = false;
+	if (upload_received != 2 * upload_entries) {
+		return BOARD_BAD_LENGTH;
+	}
+	if (entries_crc(upload_slot, upload_entries) != crc) {
+		return BOARD_BAD_CRC;
+	}
+	BoardStatus status = check_board();
+	if (status != BOARD_OK) {
+		return status;
+	}
+	// The board is good - write the header last so the slot only becomes
+	// valid now
+	storage_update_byte(SLOT_ADDRESS(upload_slot) + 1, upload_entries);
+	storage_update_word(SLOT_ADDRESS(upload_slot) + 2, crc);
+	storage_update_byte(SLOT_ADDRESS(upload_slot), BOARD_MAGIC);
+	return BOARD_OK;
+}
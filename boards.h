@@ -0,0 +1,72 @@
+/*
+ * boards.h
+ *
+ * Author: Arjun Srikanth
+ *
+ * Board layouts stored in EEPROM, so new boards can be uploaded over the
+ * serial port (see remote.h) instead of being compiled in. There are
+ * BOARD_SLOTS slots, numbered after the built in boards on the start
+ * screen.
+ *
+ * A board is stored as a list of its non-empty squares. Each entry is two
+ * bytes: the position (x in bits 0-3, y in bits 4-7) and the game object
+ * (see game.h). A slot also has a header with the number of entries and
+ * the CRC-16 of the entries (see frame_crc16_update()), and the header is
+ * only written once the whole board has arrived and been checked, so a
+ * slot never holds half a board.
+ */
+
+
+#ifndef BOARDS_H_
+#define BOARDS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "game.h"
+#include "board_library.h"
+
+// Boards in the library (see board_library.h) - numbered from 1
+#define BUILT_IN_BOARDS BOARD_LIBRARY_SIZE
+
+#define BOARD_SLOTS 4
+#define BOARD_MAX_ENTRIES 60
+
+// EEPROM used by the slots, from address 0 (each slot has a four byte
+// header and two bytes per entry)
+#define BOARDS_EEPROM_SIZE (BOARD_SLOTS * (4 + 2 * BOARD_MAX_ENTRIES))
+
+// Results of uploading a board
+typedef enum {
+	BOARD_OK,
+	BOARD_BAD_SLOT,			// no such slot
+	BOARD_NOT_STARTED,		// data or end without a start
+	BOARD_BAD_LENGTH,		// too many entries, or not as many as promised
+	BOARD_BAD_CRC,
+	BOARD_BAD_SQUARE,		// off the board, used twice or not a board object
+	BOARD_NO_START_FINISH,	// start not at (0, 0) or finish not at the end
+	BOARD_UNMATCHED			// a snake or ladder without both ends
+} BoardStatus;
+
+// Returns true if the slot holds a good board
+bool boards_slot_valid(uint8_t slot);
+
+// Return the board number (as used by initialise_game()) after the given
+// one, skipping empty slots and going back to board 1 after the last.
+uint8_t boards_next(uint8_t board_number);
+
+// Returns true if the board number is of a stored board
+bool boards_is_stored(uint8_t board_number);
+
+// Fill in the board from a slot. Returns false (leaving the board
+// unchanged) if the slot doesn't hold a good board.
+bool boards_load(uint8_t slot, uint8_t board[WIDTH][HEIGHT]);
+
+// Upload a board: start with the slot and number of entries (which erases
+// the slot), then send the entries in any number of pieces, then finish
+// with the CRC of all the entries. The board is checked before it is
+// kept. A board with no entries leaves the slot empty.
+BoardStatus boards_upload_start(uint8_t slot, uint8_t num_entries);
+BoardStatus boards_upload_data(const uint8_t* data, uint8_t length);
+BoardStatus boards_upload_finish(uint16_t crc);
+
+#endif /* BOARDS_H_ */
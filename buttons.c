@@ -8,88 +8,123 @@
 #include <avr/io.h>
 #include <avr/interrupt.h>
 
-// Global variable to keep track of the last button state so that we 
-// can detect changes when an interrupt fires. The lower 4 bits (0 to 3)
-// will correspond to the last state of port B pins 0 to 3.
-static volatile uint8_t last_button_state;
+// Debounced state of the buttons. The lower 4 bits (0 to 3) correspond to
+// port B pins 0 to 3. Only changed by sample_buttons() (in the timer
+// interrupt handler).
+static uint8_t button_state;
 
-// Our button queue. button_queue[0] is always the head of the queue. If we
-// take something off the queue we just move everything else along. We don't
-// use a circular buffer since it is usually expected that the queue is very
-// short. In most uses it will never have more than 1 element at a time.
-// This button queue can be changed by the interrupt handler below so we should
-// turn off interrupts if we're changing the queue outside the handler.
-#define BUTTON_QUEUE_SIZE 4
-static volatile uint8_t button_queue[BUTTON_QUEUE_SIZE];
-static volatile int8_t queue_length;
+// Number of samples in a row each button has read differently from its
+// debounced state, and a bit for each button whose count isn't zero (so
+// nothing needs to be done while the buttons are steady).
+static uint8_t change_count[NUM_BUTTONS];
+static uint8_t counting;
+
+// Our button queue - a circular buffer of pushes. The timer interrupt
+// handler adds pushes at queue_head and the main program takes them from
+// queue_tail. Each side only changes its own (single byte) position, so
+// interrupts never need to be turned off to use the queue. The queue is
+// empty when the positions are equal.
+#define BUTTON_QUEUE_MASK (BUTTON_QUEUE_SIZE - 1)
+#if (BUTTON_QUEUE_SIZE & BUTTON_QUEUE_MASK) != 0
+#error "BUTTON_QUEUE_SIZE must be a power of two"
+#endif
+static volatile ButtonEvent button_queue[BUTTON_QUEUE_SIZE];
+static volatile uint8_t queue_head;
+static volatile uint8_t queue_tail;
+static volatile uint16_t queue_overruns;
 
-// Setup interrupt if any of pins B0 to B3 change. We do this
-// using a pin change interrupt. These pins correspond to pin
-// change interrupts PCINT8 to PCINT11 which are covered by
-// Pin change interrupt 1.
 void init_button_interrupts(void) {
-	// Enable the interrupt (see datasheet page 77)
-	PCICR |= (1<<PCIE1);
-	
-	// Make sure the interrupt flag is cleared (by writing a 
-	// 1 to it) (see datasheet page 78)
-	PCIFR |= (1<<PCIF1);
-	
-	// Choose which pins we're interested in by setting
-	// the relevant bits in the mask register (see datasheet page 78)
-	PCMSK1 |= (1<<PCINT8)|(1<<PCINT9)|(1<<PCINT10)|(1<<PCINT11);	
+	// Pins B0 to B3 are inputs
+	DDRB &= 0xF0;
+
+	// Start from the current state of the buttons so a button which is
+	// already held down isn't counted as a push
+	button_state = PINB & 0x0F;
+	counting = 0;
 	
 	// Empty the button push queue
-	queue_length = 0;
+	clear_button_pushes();
+}
+
+uint8_t button_events_waiting(void) {
+	return queue_tail != queue_head;
+}
+
+uint8_t button_get_event(ButtonEvent* event) {
+	uint8_t tail = queue_tail;
+	if(tail == queue_head) {
+		return 0;
+	}
+	event->button = button_queue[tail].button;
+	event->time = button_queue[tail].time;
+	// Only now can the interrupt handler reuse this entry
+	queue_tail = (tail + 1) & BUTTON_QUEUE_MASK;
+	return 1;
 }
 
 int8_t button_pushed(void) {
-	int8_t return_value = NO_BUTTON_PUSHED;	// Assume no button pushed
-	if(queue_length > 0) {
-		// Remove the first element off the queue and move all the other
-		// entries closer to the front of the queue. We turn off interrupts (if on)
-		// before we make any changes to the queue. If interrupts were on
-		// we turn them back on when done.
-		return_value = button_queue[0];
-		
-		// Save whether interrupts were enabled and turn them off
-		int8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
-		cli();
-		
-		for(uint8_t i = 1; i < queue_length; i++) {
-			button_queue[i-1] = button_queue[i];
-		}
-		queue_length--;
-		
-		if(interrupts_were_enabled) {
-			// Turn them back on again
-			sei();
+	ButtonEvent event;
+	if(button_get_event(&event)) {
+		return event.button;
+	}
+	return NO_BUTTON_PUSHED;
+}
+
+void clear_button_pushes(void) {
+	queue_tail = queue_head;
+}
+
+uint16_t button_overruns(void) {
+	// The count is two bytes, so make sure the interrupt handler doesn't
+	// change it part way through reading it.
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	uint16_t overruns = queue_overruns;
+	if(interrupts_were_enabled) {
+		sei();
+	}
+	return overruns;
+}
+
+// Add a button push to the queue (if there is space)
+static void queue_push(uint8_t pin, uint32_t time) {
+	uint8_t head = queue_head;
+	uint8_t next = (head + 1) & BUTTON_QUEUE_MASK;
+	if(next == queue_tail) {
+		if(queue_overruns != 0xFFFF) {
+			queue_overruns++;
 		}
+		return;
 	}
-	return return_value;
+	button_queue[head].button = pin;
+	button_queue[head].time = time;
+	queue_head = next;
 }
 
-// Interrupt handler for a change on buttons
-ISR(PCINT1_vect) {
-	// Get the current state of the buttons. We'll compare this with
-	// the last state to see what has changed.
-	uint8_t button_state = PINB & 0x0F;
+void sample_buttons(uint32_t time) {
+	uint8_t changed = (PINB & 0x0F) ^ button_state;
+	if(!changed && !counting) {
+		return;
+	}
 	
-	// Iterate over all the buttons and see which ones have changed.
-	// Any button pushes are added to the queue of button pushes (if
-	// there is space). We ignore button releases so we're just looking
-	// for a transition from 0 in the last_button_state bit to a 1 in the 
-	// button_state.
+	// A button's new state is accepted once it has been read
+	// BUTTON_DEBOUNCE_MS times in a row. Any sample that matches the old
+	// state starts the count again. We ignore button releases so only a
+	// change from 0 to 1 is a push.
 	for(uint8_t pin = 0; pin < NUM_BUTTONS; pin++) {
-		if(queue_length < BUTTON_QUEUE_SIZE && 
-				(button_state & (1 << pin)) && 
-				!(last_button_state & (1 << pin))) {
-			// Add the button push to the queue (and update the
-			// length of the queue
-			button_queue[queue_length++] = pin;
+		uint8_t mask = (1 << pin);
+		if(!(changed & mask)) {
+			change_count[pin] = 0;
+			counting &= ~mask;
+		} else if(++change_count[pin] >= BUTTON_DEBOUNCE_MS) {
+			button_state ^= mask;
+			change_count[pin] = 0;
+			counting &= ~mask;
+			if(button_state & mask) {
+				queue_push(pin, time);
+			}
+		} else {
+			counting |= mask;
 		}
 	}
-	
-	// Remember this button state
-	last_button_state = button_state;
-}
\ No newline at end of file
+}
@@ -3,8 +3,10 @@
  *
  * Author: Peter Sutton
  *
- * We assume four push buttons (B0 to B3) are connected to pins B0 to B3. We configure
- * pin change interrupts on these pins.
+ * We assume four push buttons (B0 to B3) are connected to pins B0 to B3. The
+ * pins are sampled every millisecond (from the timer 0 interrupt handler) and
+ * a push is only recognised once a button has read as pushed for
+ * BUTTON_DEBOUNCE_MS samples in a row, so contact bounce is ignored.
  */ 
 
 
@@ -21,9 +23,22 @@
 
 #define NUM_BUTTONS 4
 
-/* Set up pin change interrupts on pins B0 to B3.
- * It is assumed that global interrupts are off when this function is called
- * and are enabled sometime after this function is called.
+// Number of consecutive 1ms samples a button must be stable for before a
+// change is accepted
+#define BUTTON_DEBOUNCE_MS 5
+
+// Number of button pushes which can be waiting. Must be a power of two - one
+// less push than this can be waiting.
+#define BUTTON_QUEUE_SIZE 8
+
+// A button push, and the time (see timer0.h) it was recognised
+typedef struct {
+	uint8_t button;
+	uint32_t time;
+} ButtonEvent;
+
+/* Set up sampling of pins B0 to B3 and empty the queue of button pushes.
+ * Buttons already held down when this is called are not counted as pushed.
  */
 void init_button_interrupts(void);
 
@@ -35,5 +50,24 @@ void init_button_interrupts(void);
  */
 int8_t button_pushed(void);
 
+/* Take the oldest button push off the queue. Returns 0 if there are no
+ * button pushes waiting, otherwise the push is copied to event.
+ */
+uint8_t button_get_event(ButtonEvent* event);
+
+/* Return non-zero if there are button pushes waiting in the queue */
+uint8_t button_events_waiting(void);
+
+/* Discard any button pushes waiting in the queue */
+void clear_button_pushes(void);
+
+/* Return the number of button pushes discarded because the queue was full */
+uint16_t button_overruns(void);
+
+/* Sample the buttons - called every millisecond from the timer 0 interrupt
+ * handler with the current time.
+ */
+void sample_buttons(uint32_t time);
+
 
-#endif /* BUTTONS_H_ */
\ No newline at end of file
+#endif /* BUTTONS_H_ */
@@ -0,0 +1,93 @@
+/*
+ * countdown.c
+ *
+ * Author: Arjun Srikanth
+ *
+ * The interrupt handler adds one to changes every time it changes any
+ * clock. countdown_read() copies a clock and then checks changes - if it
+ * has moved on, the copy may be half old and half new, so it is made
+ * again. That way interrupts never need to be turned off to read a clock.
+ */
+
+#include "countdown.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+	char digits[COUNTDOWN_DIGITS];
+	uint8_t milliseconds;	// counted towards the next tenth of a second
+	bool running;
+	bool expired;
+} Countdown;
+
+static volatile Countdown clocks[COUNTDOWN_CLOCKS];
+static volatile uint8_t changes;
+
+void countdown_set(uint8_t clock, uint16_t tenths) {
+	volatile Countdown* countdown = &clocks[clock];
+	// Stop the clock first so the interrupt handler leaves it alone
+	countdown->running = false;
+	if (tenths > 999) {
+		tenths = 999;
+	}
+	countdown->digits[0] = '0' + tenths / 100;
+	countdown->digits[1] = '0' + (tenths / 10) % 10;
+	countdown->digits[2] = '0' + tenths % 10;
+	countdown->milliseconds = 0;
+	countdown->expired = (tenths == 0);
+	changes++;
+}
+
+void countdown_run(uint8_t clock, bool run) {
+	clocks[clock].running = run && !clocks[clock].expired;
+}
+
+bool countdown_read(uint8_t clock, char* digits) {
+	uint8_t changes_before;
+	bool expired;
+	do {
+		changes_before = changes;
+		for (uint8_t i = 0; i < COUNTDOWN_DIGITS; i++) {
+			digits[i] = clocks[clock].digits[i];
+		}
+		expired = clocks[clock].expired;
+	} while (changes != changes_before);
+	return expired;
+}
+
+bool countdown_expired(uint8_t clock) {
+	return clocks[clock].expired;
+}
+
+uint16_t countdown_tenths(uint8_t clock) {
+	char digits[COUNTDOWN_DIGITS];
+	countdown_read(clock, digits);
+	return (digits[0] - '0') * 100 + (digits[1] - '0') * 10 + (digits[2] - '0');
+}
+
+void countdown_tick(void) {
+	for (uint8_t clock = 0; clock < COUNTDOWN_CLOCKS; clock++) {
+		volatile Countdown* countdown = &clocks[clock];
+		if (!countdown->running || countdown->expired
+				|| ++countdown->milliseconds < 100) {
+			continue;
+		}
+		countdown->milliseconds = 0;
+
+		// Take a tenth of a second off, borrowing from the digits to
+		// the left like subtraction by hand
+		for (int8_t i = COUNTDOWN_DIGITS - 1; i >= 0; i--) {
+			if (countdown->digits[i] != '0') {
+				countdown->digits[i]--;
+				break;
+			}
+			countdown->digits[i] = '9';
+		}
+		if (countdown->digits[0] == '0' && countdown->digits[1] == '0'
+				&& countdown->digits[2] == '0') {
+			countdown->expired = true;
+			countdown->running = false;
+		}
+		changes++;
+	}
+}
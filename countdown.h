@@ -0,0 +1,50 @@
+/*
+ * countdown.h
+ *
+ * Author: Arjun Srikanth
+ *
+ * Countdown clocks for timed games, one per player. Running clocks are
+ * counted down by the timer 0 interrupt handler (see timer0.c), so they
+ * keep perfect time however long the game loop takes. Each clock is kept
+ * as the characters shown on the terminal (seconds and tenths of a
+ * second), so showing the time needs no arithmetic.
+ */
+
+
+#ifndef COUNTDOWN_H_
+#define COUNTDOWN_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define COUNTDOWN_P1 0
+#define COUNTDOWN_P2 1
+#define COUNTDOWN_CLOCKS 2
+
+// Digits of a clock - tens of seconds, seconds, and tenths of a second,
+// as characters '0' to '9'. Clocks can be set to at most 99.9 seconds.
+#define COUNTDOWN_DIGITS 3
+
+// Set a clock to the given number of tenths of a second and stop it
+void countdown_set(uint8_t clock, uint16_t tenths);
+
+// Start or stop a clock. Stopping part way through a tenth of a second
+// doesn't lose the part already counted. A clock which has run out can't
+// be started again until it is set.
+void countdown_run(uint8_t clock, bool run);
+
+// Copy the digits of a clock into digits (which doesn't get a null
+// terminator). Returns true if the clock has run out.
+bool countdown_read(uint8_t clock, char* digits);
+
+// Returns true if a clock has run out
+bool countdown_expired(uint8_t clock);
+
+// Return the time left on a clock in tenths of a second
+uint16_t countdown_tenths(uint8_t clock);
+
+// Count down the running clocks - called every millisecond from the timer
+// 0 interrupt handler
+void countdown_tick(void);
+
+#endif /* COUNTDOWN_H_ */
@@ -6,10 +6,14 @@
 
 #include "display.h"
 #include <stdio.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
 #include <avr/pgmspace.h>
 #include "pixel_colour.h"
 #include "ledmatrix.h"
 #include "game.h"
+#include "terminal_board.h"
+#include "memory.h"
 
 // constant value used to display 'SNKLD' on launch
 static const uint8_t snkld_display[MATRIX_NUM_COLUMNS] = 
@@ -19,13 +23,61 @@ static const uint8_t snkld_display[MATRIX_NUM_COLUMNS] =
 // Seven segment display values
 uint8_t seven_seg[10] = {63, 6, 91, 79, 102, 109, 125, 7, 127, 111};
 
-uint8_t digit = 0; // 0 = right display, 1 = left display
-uint8_t value; // Value to be displayed
+// Layers making up the board display. The static board comes from the game
+// (see get_object_at()), the tokens are drawn on top of it when shown and
+// flashed on, and overlays are drawn on top of everything.
+typedef struct {
+	uint8_t x;
+	uint8_t y;
+	bool shown;		// token is part of the game
+	bool visible;	// flash state of the token
+} TokenLayer;
+
+typedef struct {
+	uint8_t x;
+	uint8_t y;
+	PixelColour colour;
+	bool in_use;
+} OverlayLayer;
+
+static TokenLayer tokens[2];
+static OverlayLayer overlays[DISPLAY_MAX_OVERLAYS];
+
+// Squares which need to be recomposed (one byte per row, one bit per column)
+// and the colour each square was last sent to the LED matrix as.
+static uint8_t dirty_squares[HEIGHT];
+static PixelColour shown_colours[WIDTH][HEIGHT];
+
+// Segment patterns currently being shown, written by seven_seg_display()
+// and read by the timer 1 interrupt handler. Index 0 is the right display
+// (dice value) and index 1 is the left display (moves).
+static volatile uint8_t seven_seg_segments[2];
 
 void initialise_display(void) {
+	memory_register(PSTR("display layers"), sizeof(tokens) + sizeof(overlays)
+			+ sizeof(dirty_squares) + sizeof(shown_colours));
+
 	// start by clearing the LED matrix
 	ledmatrix_clear();
 
+	// reset the layers - the matrix is now blank, and every square of the
+	// board needs to be drawn on the next render
+	for (uint8_t player = DISPLAY_PLAYER_1; player <= DISPLAY_PLAYER_2; player++) {
+		tokens[player].x = 0;
+		tokens[player].y = 0;
+		tokens[player].shown = false;
+		tokens[player].visible = true;
+	}
+	for (uint8_t i = 0; i < DISPLAY_MAX_OVERLAYS; i++) {
+		overlays[i].in_use = false;
+	}
+	for (uint8_t x = 0; x < WIDTH; x++) {
+		for (uint8_t y = 0; y < HEIGHT; y++) {
+			shown_colours[x][y] = MATRIX_COLOUR_EMPTY;
+		}
+	}
+	display_mark_all_dirty();
+
 	// create an array with the background colour at every position
 	PixelColour col_colours[MATRIX_NUM_ROWS];
 	for (int row = 0; row < MATRIX_NUM_ROWS; row++) {
@@ -89,11 +141,10 @@ void start_display(void) {
 	}
 }
 
-// Update the square colour to the display. The object passed can be the object
-// type or an object instance (which additionally has an ID number if 
-// applicable -see get_object_type in game.c/h)
-void update_square_colour(uint8_t x, uint8_t y, uint8_t object) {
-	// determine which colour corresponds to this object
+// Determine which colour corresponds to an object. The object passed can be
+// the object type or an object instance (which additionally has an ID number
+// if applicable -see get_object_type in game.c/h)
+static PixelColour object_colour(uint8_t object) {
 	PixelColour colour;
 	object = get_object_type(object);
 	
@@ -130,42 +181,171 @@ void update_square_colour(uint8_t x, uint8_t y, uint8_t object) {
 			colour = MATRIX_COLOUR_EMPTY;
 			break;
 	}
+	return colour;
+}
 
+// Update the square colour to the display. The object passed can be the object
+// type or an object instance (which additionally has an ID number if 
+// applicable -see get_object_type in game.c/h)
+void update_square_colour(uint8_t x, uint8_t y, uint8_t object) {
 	// Update the pixel at the given location with this colour
-	ledmatrix_update_pixel(y, WIDTH - 1 - x, colour);
+	ledmatrix_update_pixel(y, WIDTH - 1 - x, object_colour(object));
 }
 
-void display_digit(uint8_t number, uint8_t digit) {
-	PORTA = digit;
-	PORTC = seven_seg[number];
+// Mark square (x, y) as needing to be recomposed. As WIDTH is 8, each row
+// of the board fits in one byte of the dirty map.
+void display_mark_dirty(uint8_t x, uint8_t y) {
+	if (x < WIDTH && y < HEIGHT) {
+		dirty_squares[y] |= (1 << x);
+	}
 }
 
-void seven_seg_display(uint8_t moves, uint8_t dice_value) {
+void display_mark_all_dirty(void) {
+	for (uint8_t y = 0; y < HEIGHT; y++) {
+		dirty_squares[y] = 0xFF;
+	}
+}
+
+void display_set_token(uint8_t player, uint8_t x, uint8_t y) {
+	display_mark_dirty(tokens[player].x, tokens[player].y);
+	tokens[player].x = x;
+	tokens[player].y = y;
+	display_mark_dirty(x, y);
+}
+
+void display_show_token(uint8_t player, bool shown) {
+	tokens[player].shown = shown;
+	display_mark_dirty(tokens[player].x, tokens[player].y);
+}
+
+void display_set_token_flash(uint8_t player, bool visible) {
+	if (tokens[player].visible != visible) {
+		tokens[player].visible = visible;
+		display_mark_dirty(tokens[player].x, tokens[player].y);
+	}
+}
+
+void display_set_overlay(uint8_t x, uint8_t y, PixelColour colour) {
+	uint8_t free_slot = DISPLAY_MAX_OVERLAYS;
+	for (uint8_t i = 0; i < DISPLAY_MAX_OVERLAYS; i++) {
+		if (overlays[i].in_use && overlays[i].x == x && overlays[i].y == y) {
+			free_slot = i;
+			break;
+		}
+		if (!overlays[i].in_use && free_slot == DISPLAY_MAX_OVERLAYS) {
+			free_slot = i;
+		}
+	}
+	if (free_slot == DISPLAY_MAX_OVERLAYS) {
+		// No room - the overlay is ignored
+		return;
+	}
+	overlays[free_slot].in_use = true;
+	overlays[free_slot].x = x;
+	overlays[free_slot].y = y;
+	overlays[free_slot].colour = colour;
+	display_mark_dirty(x, y);
+}
+
+void display_clear_overlay(uint8_t x, uint8_t y) {
+	for (uint8_t i = 0; i < DISPLAY_MAX_OVERLAYS; i++) {
+		if (overlays[i].in_use && overlays[i].x == x && overlays[i].y == y) {
+			overlays[i].in_use = false;
+			display_mark_dirty(x, y);
+		}
+	}
+}
+
+// Work out the colour of square (x, y) from the layers. From the top down:
+// overlays, player 1's token, player 2's token and then the board itself.
+// A token only counts if it is shown and currently flashed on.
+static PixelColour compose_square(uint8_t x, uint8_t y) {
+	for (uint8_t i = 0; i < DISPLAY_MAX_OVERLAYS; i++) {
+		if (overlays[i].in_use && overlays[i].x == x && overlays[i].y == y) {
+			return overlays[i].colour;
+		}
+	}
+	for (uint8_t player = DISPLAY_PLAYER_1; player <= DISPLAY_PLAYER_2; player++) {
+		if (tokens[player].shown && tokens[player].visible &&
+				tokens[player].x == x && tokens[player].y == y) {
+			return object_colour(player == DISPLAY_PLAYER_1 ? PLAYER_1 : PLAYER_2);
+		}
+	}
+	return object_colour(get_object_at(x, y));
+}
+
+PixelColour display_get_colour(uint8_t x, uint8_t y) {
+	return shown_colours[x][y];
+}
+
+void display_render(void) {
+	for (uint8_t y = 0; y < HEIGHT; y++) {
+		uint8_t dirty = dirty_squares[y];
+		if (dirty == 0) {
+			continue;
+		}
+		dirty_squares[y] = 0;
+		for (uint8_t x = 0; x < WIDTH; x++) {
+			if (!(dirty & (1 << x))) {
+				continue;
+			}
+			PixelColour colour = compose_square(x, y);
+			if (colour != shown_colours[x][y]) {
+				shown_colours[x][y] = colour;
+				ledmatrix_update_pixel(y, WIDTH - 1 - x, colour);
+				terminal_board_update(x, y, colour);
+			}
+		}
+	}
+	terminal_board_end_frame();
+}
+
+void init_seven_seg(void) {
 	// Set Port C (all pins) to be outputs
 	DDRC = 0xff;
 
 	// Set Port A, pin 0 to be an output
-	DDRA = (1<<0);
+	DDRA |= (1<<0);
+
+	seven_seg_segments[0] = seven_seg[0];
+	seven_seg_segments[1] = seven_seg[0];
 
 	// Setup timer/counter 1 so that it reaches an output compare
 	// match every 1 millisecond (1000 times per second) and then
-	// resets to 0
-	OCR1A = 500;
-	TCCR1A = (0<<COM1A1) | (1<<COM1A0);
+	// resets to 0. Each compare match shows the other digit.
+	OCR1A = 999;
+	TCCR1A = 0;
 	TCCR1B = (1<<WGM12) | (1<<CS11);
 
-	if (digit == 0)
-	{
-		value = dice_value;
-	}else {
-		value = moves%10;
-	}
-	display_digit(value, digit);
-	digit = ~(digit);
+	// Enable an interrupt on output compare match and make sure the
+	// interrupt flag is cleared by writing a 1 to it.
+	TIMSK1 |= (1<<OCIE1A);
+	TIFR1 = (1<<OCF1A);
+}
 
-	while ((TIFR1 & (1<<OCF1A)) == 0) {
-		;
+void display_digit(uint8_t number, uint8_t digit) {
+	PORTA = (PORTA & ~(1<<0)) | (digit & (1<<0));
+	PORTC = seven_seg[number];
+}
+
+void seven_seg_display(uint8_t moves, uint8_t dice_value) {
+	// Only touch the shared patterns when the values have changed - the
+	// interrupt handler keeps showing whatever is there.
+	uint8_t right = seven_seg[dice_value % 10];
+	uint8_t left = seven_seg[moves % 10];
+	if (seven_seg_segments[0] != right) {
+		seven_seg_segments[0] = right;
+	}
+	if (seven_seg_segments[1] != left) {
+		seven_seg_segments[1] = left;
 	}
+}
 
-	TIFR1 &= (1<<OCF1A);
-}
\ No newline at end of file
+// Alternate between the two digits every millisecond. The digit select
+// line (port A, pin 0) is low for the right display and high for the left.
+ISR(TIMER1_COMPA_vect) {
+	static uint8_t digit = 0;
+	digit ^= 1;
+	PORTA = (PORTA & ~(1<<0)) | digit;
+	PORTC = seven_seg_segments[digit];
+}
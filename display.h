@@ -8,6 +8,8 @@
 #ifndef DISPLAY_H_
 #define DISPLAY_H_
 
+#include <stdint.h>
+#include <stdbool.h>
 #include "pixel_colour.h"
 
 // Offset for the LED matrix to cater for any game border offset to the edge
@@ -22,6 +24,7 @@
 #define MATRIX_COLOUR_P2        COLOUR_LIGHT_GREEN
 #define MATRIX_COLOUR_SNAKE		COLOUR_RED
 #define MATRIX_COLOUR_LADDER	COLOUR_GREEN
+#define MATRIX_COLOUR_TARGET	COLOUR_YELLOW	// where a moving token is going
 
 // Initialise the display for the board, this creates the display
 // for an empty board.
@@ -31,11 +34,62 @@ void initialise_display(void);
 void start_display(void);
 
 // Updates the colour at square (x, y) to be the colour
-// of the object 'object'.
+// of the object 'object'. This writes straight to the LED matrix - the game
+// should go through the layers below instead.
 void update_square_colour(uint8_t x, uint8_t y, uint8_t object);
 
+// The board display is built up from layers: the static board, the player
+// tokens (with their flash state) and overlays. Changing a layer only marks
+// the affected squares as dirty; display_render() then works out the final
+// colour of each dirty square once and sends it to the LED matrix if it has
+// changed. initialise_display() hides both tokens and marks every square
+// dirty.
+#define DISPLAY_PLAYER_1 0
+#define DISPLAY_PLAYER_2 1
 
+// Maximum number of squares which can have an overlay at once
+#define DISPLAY_MAX_OVERLAYS 4
+
+// Mark square (x, y), or every square, as needing to be redrawn. Used when
+// the board itself changes.
+void display_mark_dirty(uint8_t x, uint8_t y);
+void display_mark_all_dirty(void);
+
+// Move the token of the given player to square (x, y).
+void display_set_token(uint8_t player, uint8_t x, uint8_t y);
+
+// Show or hide the token of the given player (e.g. player 2 is hidden in a
+// single player game).
+void display_show_token(uint8_t player, bool shown);
+
+// Set the flash state of the token of the given player.
+void display_set_token_flash(uint8_t player, bool visible);
+
+// Draw square (x, y) in the given colour over everything else, or remove
+// that overlay. Overlays past DISPLAY_MAX_OVERLAYS are ignored.
+void display_set_overlay(uint8_t x, uint8_t y, PixelColour colour);
+void display_clear_overlay(uint8_t x, uint8_t y);
+
+// Return the colour square (x, y) was last drawn in.
+PixelColour display_get_colour(uint8_t x, uint8_t y);
+
+// Compose every dirty square and update the LED matrix (and the terminal
+// mirror of the board, see terminal_board.h). Should be called once per
+// iteration of the game loop.
+void display_render(void);
+
+
+// Set up the seven segment display and timer 1. The two digits are
+// multiplexed by the timer 1 compare match interrupt, so interrupts
+// must be enabled globally for the display to work.
+void init_seven_seg(void);
+
+// Show the digit 'number' on the given display (0 = right, 1 = left).
 void display_digit(uint8_t number, uint8_t digit);
+
+// Set the values shown on the seven segment display - the number of moves
+// (mod 10) on the left display and the dice value on the right. This only
+// updates the values, the interrupt handler does the display.
 void seven_seg_display(uint8_t moves, uint8_t dice_value);
 
 
@@ -0,0 +1,44 @@
+/*
+ * format.c
+ *
+ * Author: Arjun Srikanth
+ */
+
+#include "format.h"
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+// Powers of ten for the digits of a 16 bit number (from the most
+// significant digit down). Each digit is found by repeated subtraction,
+// which is far cheaper than division on the AVR.
+static const uint16_t powers_of_ten[] PROGMEM = {10000, 1000, 100, 10, 1};
+#define MAX_DIGITS 5
+
+uint8_t format_string_P(char* buf, uint8_t pos, const char* text) {
+	char c;
+	while ((c = pgm_read_byte(text++)) != 0) {
+		buf[pos++] = c;
+	}
+	return pos;
+}
+
+uint8_t format_uint(char* buf, uint8_t pos, uint16_t value, uint8_t min_digits) {
+	uint8_t started = 0;
+	for (uint8_t i = 0; i < MAX_DIGITS; i++) {
+		uint16_t power = pgm_read_word(&powers_of_ten[i]);
+		char digit = '0';
+		while (value >= power) {
+			value -= power;
+			digit++;
+		}
+		// Leading zeros are skipped unless they are needed for padding
+		// (the last digit is always written)
+		if (digit != '0' || MAX_DIGITS - i <= min_digits || i == MAX_DIGITS - 1) {
+			started = 1;
+		}
+		if (started) {
+			buf[pos++] = digit;
+		}
+	}
+	return pos;
+}
@@ -0,0 +1,27 @@
+/*
+ * format.h
+ *
+ * Author: Arjun Srikanth
+ *
+ * Minimal text formatting for output on the game's hot path (the HUD and
+ * the terminal board mirror). Text is built up in a caller supplied
+ * buffer - each function appends to buf at position pos and returns the
+ * position after what it wrote. Numbers are formatted without division
+ * and nothing here uses printf, so it is much cheaper than printf_P.
+ * The caller must make sure the buffer is big enough.
+ */
+
+
+#ifndef FORMAT_H_
+#define FORMAT_H_
+
+#include <stdint.h>
+
+// Append a string from program memory (without its terminating null)
+uint8_t format_string_P(char* buf, uint8_t pos, const char* text);
+
+// Append an unsigned number in decimal, padded with leading zeros to at
+// least min_digits digits (so a min_digits of 1 gives no padding).
+uint8_t format_uint(char* buf, uint8_t pos, uint16_t value, uint8_t min_digits);
+
+#endif /* FORMAT_H_ */
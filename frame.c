@@ -0,0 +1,115 @@
+/*
+ * frame.c
+ *
+ * Author: Arjun Srikanth
+ */
+
+#include "frame.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// Parser states
+#define WAIT_SYNC 0
+#define WAIT_TYPE 1
+#define WAIT_LENGTH 2
+#define WAIT_PAYLOAD 3
+#define WAIT_CRC 4
+
+uint8_t frame_crc_update(uint8_t crc, uint8_t data) {
+	crc ^= data;
+	for (uint8_t i = 0; i < 8; i++) {
+		if (crc & 0x80) {
+			crc = (crc << 1) ^ 0x07;
+		} else {
+			crc <<= 1;
+		}
+	}
+	return crc;
+}
+
+uint16_t frame_crc16_update(uint16_t crc, uint8_t data) {
+	crc ^= (uint16_t) data << 8;
+	for (uint8_t i = 0; i < 8; i++) {
+		if (crc & 0x8000) {
+			crc = (crc << 1) ^ 0x1021;
+		} else {
+			crc <<= 1;
+		}
+	}
+	return crc;
+}
+
+uint16_t frame_crc16(const uint8_t* data, uint8_t length) {
+	uint16_t crc = 0xFFFF;
+	for (uint8_t i = 0; i < length; i++) {
+		crc = frame_crc16_update(crc, data[i]);
+	}
+	return crc;
+}
+
+uint8_t frame_build(uint8_t* buf, uint8_t type, const uint8_t* payload,
+		uint8_t length) {
+	uint8_t crc = frame_crc_update(0, type);
+	crc = frame_crc_update(crc, length);
+	buf[0] = FRAME_SYNC;
+	buf[1] = type;
+	buf[2] = length;
+	for (uint8_t i = 0; i < length; i++) {
+		buf[3 + i] = payload[i];
+		crc = frame_crc_update(crc, payload[i]);
+	}
+	buf[3 + length] = crc;
+	return length + FRAME_OVERHEAD;
+}
+
+void frame_parser_init(FrameParser* parser) {
+	parser->state = WAIT_SYNC;
+}
+
+bool frame_parser_idle(const FrameParser* parser) {
+	return parser->state == WAIT_SYNC;
+}
+
+bool frame_parser_feed(FrameParser* parser, uint8_t byte) {
+	switch (parser->state) {
+		case WAIT_SYNC:
+			if (byte == FRAME_SYNC) {
+				parser->state = WAIT_TYPE;
+			}
+			break;
+		case WAIT_TYPE:
+			parser->type = byte;
+			parser->crc = frame_crc_update(0, byte);
+			parser->state = WAIT_LENGTH;
+			break;
+		case WAIT_LENGTH:
+			if (byte > FRAME_MAX_PAYLOAD) {
+				// Can't be a frame - look for the next one. The sync
+				// might have been lost, so this byte could be one.
+				parser->state = (byte == FRAME_SYNC) ? WAIT_TYPE : WAIT_SYNC;
+				break;
+			}
+			parser->length = byte;
+			parser->count = 0;
+			parser->crc = frame_crc_update(parser->crc, byte);
+			parser->state = byte ? WAIT_PAYLOAD : WAIT_CRC;
+			break;
+		case WAIT_PAYLOAD:
+			parser->payload[parser->count++] = byte;
+			parser->crc = frame_crc_update(parser->crc, byte);
+			if (parser->count == parser->length) {
+				parser->state = WAIT_CRC;
+			}
+			break;
+		default:
+			parser->state = WAIT_SYNC;
+			if (byte == parser->crc) {
+				return true;
+			}
+			if (byte == FRAME_SYNC) {
+				parser->state = WAIT_TYPE;
+			}
+			break;
+	}
+	return false;
+}
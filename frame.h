@@ -0,0 +1,68 @@
+/*
+ * frame.h
+ *
+ * Author: Arjun Srikanth
+ *
+ * Binary frames sent over the serial port alongside (or instead of) the
+ * terminal text. A frame is
+ *
+ *     FRAME_SYNC, type, length, payload (length bytes), crc
+ *
+ * where crc is the CRC-8 (polynomial 0x07, initial value 0) of the type,
+ * length and payload bytes. Terminal text never contains FRAME_SYNC, so a
+ * receiver can find frames in a stream of mixed text and frames and
+ * recover from lost bytes. Nothing here touches the hardware, so this file
+ * is also built into the host tools (see host/).
+ */
+
+
+#ifndef FRAME_H_
+#define FRAME_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define FRAME_SYNC ((uint8_t) 0xA5)
+
+// Largest payload in a frame, and the bytes a frame adds to its payload
+#define FRAME_MAX_PAYLOAD 16
+#define FRAME_OVERHEAD 4
+#define FRAME_MAX_SIZE (FRAME_MAX_PAYLOAD + FRAME_OVERHEAD)
+
+// Add a byte to a CRC-8
+uint8_t frame_crc_update(uint8_t crc, uint8_t data);
+
+// Add a byte to a CRC-16 (polynomial 0x1021, start with 0xFFFF) - used to
+// check larger amounts of data sent in frames
+uint16_t frame_crc16_update(uint16_t crc, uint8_t data);
+
+// CRC-16 of length bytes of data
+uint16_t frame_crc16(const uint8_t* data, uint8_t length);
+
+// Build a frame in buf (which must hold FRAME_MAX_SIZE bytes) and return
+// its size. length must be no more than FRAME_MAX_PAYLOAD.
+uint8_t frame_build(uint8_t* buf, uint8_t type, const uint8_t* payload,
+		uint8_t length);
+
+// Receiver state - bytes are fed in one at a time with frame_parser_feed()
+typedef struct {
+	uint8_t state;
+	uint8_t type;
+	uint8_t length;
+	uint8_t count;
+	uint8_t crc;
+	uint8_t payload[FRAME_MAX_PAYLOAD];
+} FrameParser;
+
+void frame_parser_init(FrameParser* parser);
+
+// Returns true if the parser is waiting for the start of a frame
+bool frame_parser_idle(const FrameParser* parser);
+
+// Feed the next received byte to the parser. Returns true when the byte
+// completes a frame with a good CRC - its type, length and payload are
+// then in the parser until the next byte is fed. Anything which isn't a
+// good frame is skipped.
+bool frame_parser_feed(FrameParser* parser, uint8_t byte);
+
+#endif /* FRAME_H_ */
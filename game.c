@@ -8,61 +8,21 @@
 
 
 #include "game.h"
+#include "boards.h"
+#include "board_library.h"
+#include "frame.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include "display.h"
 #include "terminalio.h"
+#include "animation.h"
+#include "memory.h"
+#include <avr/pgmspace.h>
 
 uint8_t board[WIDTH][HEIGHT];
 
-// The initial game layout. Note that this is laid out in such a way that
-// starting_layout[x][y] does not correspond to an (x,y) coordinate but is a
-// better visual representation (but still somewhat messy).
-// In our reference system, (0,0) is the bottom left, but (0,0) in this array
-// is the top left.
-static const uint8_t starting_layout[HEIGHT][WIDTH] =
-{
-	{FINISH_LINE, 0, 0, 0, 0, 0, 0, 0},
-	{0, SNAKE_START | 4, 0, 0, LADDER_END | 4, 0, 0, 0},
-	{0, SNAKE_MIDDLE, 0, LADDER_MIDDLE, 0, 0, 0, 0},
-	{0, SNAKE_MIDDLE, LADDER_START | 4, 0, 0, 0, 0, 0},
-	{0, SNAKE_END | 4, 0, 0, 0, 0, SNAKE_START | 3, 0},
-	{0, 0, 0, 0, LADDER_END | 3, 0, SNAKE_MIDDLE, 0},
-	{SNAKE_START | 2, 0, 0, 0, LADDER_MIDDLE, 0, SNAKE_MIDDLE, 0},
-	{0, SNAKE_MIDDLE, 0, 0, LADDER_START | 3, 0, SNAKE_END | 3, 0},
-	{0, 0, SNAKE_END | 2, 0, 0, 0, 0, 0},
-	{0, 0, 0, 0, 0, 0, 0, 0},
-	{0, 0, 0, 0, 0, 0, 0, 0},
-	{0, 0, 0, SNAKE_START | 1, 0, 0, 0, LADDER_END | 1},
-	{0, LADDER_END | 2, 0, SNAKE_MIDDLE, 0, 0, LADDER_MIDDLE, 0},
-	{0, LADDER_MIDDLE, 0, SNAKE_MIDDLE, 0, LADDER_START | 1, 0, 0},
-	{0, LADDER_START | 2, 0, SNAKE_MIDDLE, 0, 0, 0, 0},
-	{START_POINT, 0, 0, SNAKE_END | 1, 0, 0, 0, 0}
-};
-
-static const uint8_t custom_layout[HEIGHT][WIDTH] = 
-{
-	{FINISH_LINE, SNAKE_START | 5, 0, 0, 0, LADDER_END | 4, 0, 0},
-	{0, SNAKE_MIDDLE, 0, 0, LADDER_MIDDLE, 0, 0, 0},
-	{0, SNAKE_MIDDLE, 0, LADDER_MIDDLE, 0, 0, 0, 0},
-	{0, SNAKE_MIDDLE, LADDER_START | 4, SNAKE_START | 4, 0, 0, 0, 0},
-	{0, SNAKE_END | 5, 0, SNAKE_MIDDLE, LADDER_END | 3, 0, 0, 0},
-	{0, 0, 0, SNAKE_END | 4, 0, LADDER_MIDDLE, 0, 0},
-	{0, 0, 0, 0, 0, 0, LADDER_START | 3, 0},
-	{0, 0, 0, 0, SNAKE_START | 3, 0, 0, 0},
-	{0, SNAKE_START | 2, 0, 0, 0, SNAKE_MIDDLE, 0, 0},
-	{0, SNAKE_END | 2, 0, 0, 0, 0, SNAKE_END | 3, LADDER_END | 2},
-	{0, 0, 0, 0, 0, 0, 0, LADDER_MIDDLE},
-	{0, SNAKE_START | 1, 0, 0, 0, 0, 0, LADDER_START | 2},
-	{0, LADDER_END | 1, SNAKE_MIDDLE, 0, 0, 0, 0, 0},
-	{0, LADDER_MIDDLE, 0, SNAKE_MIDDLE, 0, 0, 0, 0},
-	{0, LADDER_MIDDLE, 0, 0, SNAKE_MIDDLE, 0, 0, 0},
-	{START_POINT, LADDER_START | 1, 0, 0, 0, SNAKE_END | 1, 0, 0}
-};
-
-
 // The player(s) is not stored in the board itself to avoid overwriting game
 // elements when the player is moved.
 int8_t player_1_x;
@@ -76,12 +36,8 @@ uint8_t player_visible;
 // For flashing the player 2 icon
 uint8_t player_2_visible;
 
-// Added by student (Arjun Srikanth)
-// true if player moved up a row, false if not
-bool p1_moved_up = false;
-bool p2_moved_up = false;
-
 void initialise_game(bool two_player_game, uint8_t board_number) {
+	memory_register(PSTR("game board"), sizeof(board));
 	
 	// initialise the display we are using.
 	initialise_display();
@@ -97,34 +53,27 @@ void initialise_game(bool two_player_game, uint8_t board_number) {
 
 	player_visible = 0;
 
-	// go through and initialise the state of the playing_field
-	if (board_number == 1) {
-		for (int x = 0; x < WIDTH; x++) {
-			for (int y = 0; y < HEIGHT; y++) {
-				// initialise this square based on the starting layout
-				// the indices here are to ensure the starting layout
-				// could be easily visualised when declared
-				board[x][y] = starting_layout[HEIGHT - 1 - y][x];
-				update_square_colour(x, y, get_object_type(board[x][y]));
-			}
-		}
-	} else if(board_number == 2) {
-		for (int x = 0; x < WIDTH; x++) {
-			for (int y = 0; y < HEIGHT; y++) {
-				// initialise this square based on the starting layout
-				// the indices here are to ensure the starting layout
-				// could be easily visualised when declared
-				board[x][y] = custom_layout[HEIGHT - 1 - y][x];
-				update_square_colour(x, y, get_object_type(board[x][y]));
-			}
-		}
+	// no steps should be left over from the last game
+	animation_init();
+
+	// Fill in the board from the library or a stored board. A board which
+	// can't be loaded is replaced by the first board in the library.
+	bool loaded;
+	if (boards_is_stored(board_number)) {
+		loaded = boards_load(board_number - BUILT_IN_BOARDS - 1, board);
+	} else {
+		loaded = board_library_load(board_number, board);
+	}
+	if (!loaded) {
+		board_library_load(1, board);
 	}
 	
-	update_square_colour(player_1_x, player_1_y, PLAYER_1);
+	display_show_token(DISPLAY_PLAYER_1, true);
 	if (two_player_game) {
 		player_2_visible = 0;
-		update_square_colour(player_2_x, player_2_y, PLAYER_2);
+		display_show_token(DISPLAY_PLAYER_2, true);
 	}
+	display_render();
 }
 
 // Return the game object at the specified position (x, y). This function does
@@ -152,6 +101,24 @@ uint8_t get_object_identifier(uint8_t object) {
 	return object & 0x0F;
 }
 
+// Move (x, y) one square forward along the path. The path snakes up the
+// board - even rows are crossed left to right and odd rows right to left.
+static void step_forward(int8_t* x, int8_t* y) {
+	if (*y % 2 == 0) {
+		if (*x == WIDTH - 1) {
+			*y += 1;
+		} else {
+			*x += 1;
+		}
+	} else {
+		if (*x == 0) {
+			*y += 1;
+		} else {
+			*x -= 1;
+		}
+	}
+}
+
 // Move the player by the given number of spaces forward.
 void move_player_n(uint8_t num_spaces, bool move_player_1) {
 	/* suggestions for implementation:
@@ -170,113 +137,31 @@ void move_player_n(uint8_t num_spaces, bool move_player_1) {
 	 *		cursor is flashed.
 	 */
 	// YOUR CODE HERE
-	int8_t prev_player_x, prev_player_y;
 	int8_t player_x, player_y;
 	if (move_player_1) {
-		prev_player_x = player_1_x;
-		prev_player_y = player_1_y;
 		player_x = player_1_x;
 		player_y = player_1_y;
-	}
-	else {
-		prev_player_x = player_2_x;
-		prev_player_y = player_2_y;
+	} else {
 		player_x = player_2_x;
 		player_y = player_2_y;
 	}
 
-	int8_t diff = player_x - num_spaces;
-	// Boolean values to check player's position
-	
-	//	Player is at the end of the row (right side)
-	bool player_end_right = (player_x == WIDTH-1);
-	
-	//	Player is at the end of the row (left side)
-	bool player_end_left = ((player_x==0) & (player_y%2));
-
-	if(( player_end_right | player_end_left) & ((move_player_1 && !p1_moved_up) || (!move_player_1 && !p2_moved_up))) {
-		if(move_player_1) {
-			p1_moved_up = true;
-		} else {
-			p2_moved_up = true;
-		}
-		player_y += 1;
-
-		if (player_end_left) {
-			player_x += num_spaces-1;
-		} else {
-			player_x -= num_spaces-1;
-		}
-	}else if(player_y%2) {
-		if (move_player_1) {
-			p1_moved_up = false;
-		} else {
-			p2_moved_up = false;
-		}
-
-		// Make sure the player doesn't go past the end point
-		if ((diff < 0) & (player_y == HEIGHT-1)) {
-			player_x = 0;
-		} else if (diff < 0) {
-			int8_t remaining_steps = num_spaces - (player_x+1);
-			int8_t dx = player_x - remaining_steps;
-			player_x -= dx;
-			player_y += 1;
-			if (move_player_1) {
-				p1_moved_up = true;
-			} else {
-				p2_moved_up = true;
-			}
-
-		} else {
-			player_x -= num_spaces;
-		}
-	}else{
-		if (move_player_1) {
-			p1_moved_up = false;
-		} else {
-			p2_moved_up = false;
-		}
-
-		if(player_x + num_spaces > WIDTH-1) {
-			// Steps to end of row
-			int8_t x_steps = WIDTH - player_x;
-
-			// remaining steps from x += x_steps, y += 1
-			int8_t remaining_steps = num_spaces - (x_steps - 1);
-			
-			// number of x_steps player needs to take to reach new point
-			int8_t dx = x_steps - remaining_steps;
-
-			player_x += dx;
-			player_y += 1;
-			if (move_player_1) {
-				p1_moved_up = true;
-			} else {
-				p2_moved_up = true;
-			}
-
-		}else {
-			player_x += num_spaces;
+	// Walk forward one square at a time, queueing each square so the token
+	// is animated along the path. The player can't go past the finish line.
+	for (uint8_t i = 0; i < num_spaces; i++) {
+		if (player_x == 0 && player_y == HEIGHT - 1) {
+			break;
 		}
+		step_forward(&player_x, &player_y);
+		animation_queue_step(move_player_1, player_x, player_y);
 	}
 
-	// Check if player is at end tile
-	if((prev_player_x == 0) & (prev_player_y == HEIGHT-1)) {
-		player_x = prev_player_x;
-		player_y = prev_player_y;
-	}
-	
-	update_square_colour(prev_player_x, prev_player_y, get_object_at(prev_player_x, prev_player_y));
-	if (move_player_1){
+	if (move_player_1) {
 		player_1_x = player_x;
 		player_1_y = player_y;
-		update_square_colour(player_1_x, player_1_y, PLAYER_1);
-
 	} else {
 		player_2_x = player_x;
 		player_2_y = player_y;
-		update_square_colour(player_2_x, player_2_y, PLAYER_2);
 	}
 }
 
@@ -297,17 +182,12 @@ void move_player(int8_t dx, int8_t dy, bool move_player_1) {
 	 *		cursor is flashed.
 	 */	
 	// YOUR CODE HERE
-	int8_t prev_player_x, prev_player_y;
 	int8_t player_x, player_y;
 	
 	if (move_player_1) {
-		prev_player_x = player_1_x;
-		prev_player_y = player_1_y;
 		player_x = player_1_x;
 		player_y = player_1_y;
 	} else {
-		prev_player_x = player_2_x;
-		prev_player_y = player_2_y;
 		player_x = player_2_x;
 		player_y = player_2_y;
 	}
@@ -328,13 +208,11 @@ void move_player(int8_t dx, int8_t dy, bool move_player_1) {
 	if (move_player_1) {
 		player_1_x = player_x;
 		player_1_y = player_y;
-		update_square_colour(player_1_x, player_1_y, PLAYER_1);
 	} else {
 		player_2_x = player_x;
 		player_2_y = player_y;
-		update_square_colour(player_2_x, player_2_y, PLAYER_2);
 	}
-	update_square_colour(prev_player_x, prev_player_y, get_object_at(prev_player_x, prev_player_y));	
+	animation_queue_step(move_player_1, player_x, player_y);
 }
 
 // Flash the player icon on and off. This should be called at a regular
@@ -342,31 +220,58 @@ void move_player(int8_t dx, int8_t dy, bool move_player_1) {
 // 500 ms flash.
 void flash_player_cursor(void) {
 	
-	if (player_visible) {
-		// we need to flash the player off, it should be replaced by
-		// the colour of the object which is at that location
-		uint8_t object_at_cursor = get_object_at(player_1_x, player_1_y);
-		update_square_colour(player_1_x, player_1_y, object_at_cursor);
-	} else {
-		// we need to flash the player on
-		update_square_colour(player_1_x, player_1_y, PLAYER_1);
+	// The token is being drawn by the animation - leave it visible
+	if (animation_player_busy(true)) {
+		player_visible = 1;
+		display_set_token_flash(DISPLAY_PLAYER_1, true);
+		return;
 	}
 	player_visible = 1 - player_visible; //alternate between 0 and 1
+	// When flashed off, the object at the player's location shows through
+	display_set_token_flash(DISPLAY_PLAYER_1, player_visible);
 }
 
 void flash_player_2_cursor(void) {
-	if (player_2_visible) {
-		// we need to flash the player off, it should be replaced by
-		// the colour of the object which is at that location
-		uint8_t object_at_cursor = get_object_at(player_2_x, player_2_y);
-		update_square_colour(player_2_x, player_2_y, object_at_cursor);
-	} else {
-		// we need to flash the player on
-		update_square_colour(player_2_x, player_2_y, PLAYER_2);
+	if (animation_player_busy(false)) {
+		player_2_visible = 1;
+		display_set_token_flash(DISPLAY_PLAYER_2, true);
+		return;
 	}
 	player_2_visible = 1 - player_2_visible; //alternate between 0 and 1
+	display_set_token_flash(DISPLAY_PLAYER_2, player_2_visible);
 
 }
+uint16_t board_checksum(void) {
+	uint16_t crc = 0xFFFF;
+	for (uint8_t x = 0; x < WIDTH; x++) {
+		for (uint8_t y = 0; y < HEIGHT; y++) {
+			crc = frame_crc16_update(crc, board[x][y]);
+		}
+	}
+	return crc;
+}
+
+void get_player_position(bool player_1, int8_t* x, int8_t* y) {
+	if (player_1) {
+		*x = player_1_x;
+		*y = player_1_y;
+	} else {
+		*x = player_2_x;
+		*y = player_2_y;
+	}
+}
+
+void set_player_position(bool player_1, int8_t x, int8_t y) {
+	if (player_1) {
+		player_1_x = x;
+		player_1_y = y;
+	} else {
+		player_2_x = x;
+		player_2_y = y;
+	}
+	display_set_token(player_1 ? DISPLAY_PLAYER_1 : DISPLAY_PLAYER_2, x, y);
+}
+
 // Returns 1 if the game is over, 0 otherwise.
 uint8_t is_game_over(void) {
 	// YOUR CODE HERE
@@ -392,6 +297,47 @@ uint8_t roll_dice(void) {
 	return dice_value + 1; // 1 to 6 (inclusive)
 }
 
+// Number of squares between (x1, y1) and (x2, y2) when diagonal moves are
+// allowed.
+static uint8_t square_distance(int8_t x1, int8_t y1, int8_t x2, int8_t y2) {
+	uint8_t dx = (x1 > x2) ? x1 - x2 : x2 - x1;
+	uint8_t dy = (y1 > y2) ? y1 - y2 : y2 - y1;
+	return (dx > dy) ? dx : dy;
+}
+
+// Queue the slide of a token from (x, y) to (end_x, end_y) through the
+// connecting middle squares of a snake or ladder. Each step goes to the
+// neighbouring middle square which is closest to the end. If no middle
+// square gets closer, the token goes straight to the end.
+static void queue_slide(bool move_player_1, int8_t x, int8_t y,
+		int8_t end_x, int8_t end_y, uint8_t middle_type) {
+	while (square_distance(x, y, end_x, end_y) > 1) {
+		int8_t next_x = x;
+		int8_t next_y = y;
+		uint8_t best_distance = square_distance(x, y, end_x, end_y);
+		for (int8_t dx = -1; dx <= 1; dx++) {
+			for (int8_t dy = -1; dy <= 1; dy++) {
+				if (get_object_type(get_object_at(x + dx, y + dy)) != middle_type) {
+					continue;
+				}
+				uint8_t distance = square_distance(x + dx, y + dy, end_x, end_y);
+				if (distance < best_distance) {
+					best_distance = distance;
+					next_x = x + dx;
+					next_y = y + dy;
+				}
+			}
+		}
+		if (next_x == x && next_y == y) {
+			break;
+		}
+		x = next_x;
+		y = next_y;
+		animation_queue_step(move_player_1, x, y);
+	}
+	animation_queue_step(move_player_1, end_x, end_y);
+}
+
 // Moves player to end of snake/ladder (if player is at the start of the snake/ladder)
 void snake_ladder_func(bool move_player_1){
 	// Get the object at the player's position
@@ -411,6 +357,10 @@ void snake_ladder_func(bool move_player_1){
 	
 	uint8_t tempObject;
 
+	// Where the player ends up (stays put unless on a snake/ladder start)
+	int8_t end_x = player_x;
+	int8_t end_y = player_y;
+
 	// Check if the object is either a SNAKE_START or LADDER_START
 	if (object_type == SNAKE_START) {
 
@@ -419,9 +369,11 @@ void snake_ladder_func(bool move_player_1){
 			for (int j = 0; j < HEIGHT; j++) {
 				tempObject = get_object_at(i, j);
 				
-				// Move player to SNAKE_END
+				// Slide player down to SNAKE_END
 				if (get_object_type(tempObject) == SNAKE_END && object_identifier == get_object_identifier(tempObject)) {
-					move_player(i-player_x, j-player_y, move_player_1);
+					queue_slide(move_player_1, player_x, player_y, i, j, SNAKE_MIDDLE);
+					end_x = i;
+					end_y = j;
 				}				
 			}
 		}
@@ -432,11 +384,21 @@ void snake_ladder_func(bool move_player_1){
 			for (int j = 0; j < HEIGHT; j++) {
 				tempObject = get_object_at(i, j);
 
-				// Move player to LADDER_END
+				// Climb player up to LADDER_END
 				if (get_object_type(tempObject) == LADDER_END  && object_identifier == get_object_identifier(tempObject)) {
-					move_player(i-player_x, j-player_y, move_player_1);
+					queue_slide(move_player_1, player_x, player_y, i, j, LADDER_MIDDLE);
+					end_x = i;
+					end_y = j;
 				}				
 			}
 		}
 	}
+
+	if (move_player_1) {
+		player_1_x = end_x;
+		player_1_y = end_y;
+	} else {
+		player_2_x = end_x;
+		player_2_y = end_y;
+	}
 }
\ No newline at end of file
@@ -57,6 +57,18 @@ void move_player_n(uint8_t num_spaces, bool move_player_1);
 // around the display if moved 'off' the display.
 void move_player(int8_t dx, int8_t dy, bool move_player_1);
 
+// Return a checksum of the layout of the board, so boards on two units can
+// be compared
+uint16_t board_checksum(void);
+
+// Get the square the player is on. (This is where the player is in the
+// game - the token shown on the display may still be moving there.)
+void get_player_position(bool player_1, int8_t* x, int8_t* y);
+
+// Put the player straight onto square (x, y) without animating the move,
+// e.g. when a saved game is restored.
+void set_player_position(bool player_1, int8_t x, int8_t y);
+
 // Flash the player icon on and off. This should be called at a regular
 // interval (see where this is called in project.c) to create a consistent
 // 500 ms flash.
@@ -0,0 +1,23 @@
+/*
+ * eeprom.h
+ *
+ * Author: Arjun Srikanth
+ *
+ * Stand-in for the avr-libc header (see io.h). The functions use the
+ * simulated EEPROM in avr_sim.c, which is also what EEDR reads and writes.
+ */
+
+#ifndef HOST_EEPROM_H_
+#define HOST_EEPROM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+uint8_t eeprom_read_byte(const uint8_t* address);
+uint16_t eeprom_read_word(const uint16_t* address);
+void eeprom_read_block(void* data, const void* address, size_t length);
+void eeprom_update_byte(uint8_t* address, uint8_t value);
+void eeprom_update_word(uint16_t* address, uint16_t value);
+void eeprom_update_block(const void* data, void* address, size_t length);
+
+#endif /* HOST_EEPROM_H_ */
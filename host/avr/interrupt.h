@@ -0,0 +1,20 @@
+/*
+ * interrupt.h
+ *
+ * Author: Arjun Srikanth
+ *
+ * Stand-in for the avr-libc header (see io.h). Nothing interrupts the
+ * host tests, so cli() and sei() only change the interrupt enable bit
+ * the modules check in SREG.
+ */
+
+#ifndef HOST_INTERRUPT_H_
+#define HOST_INTERRUPT_H_
+
+#include <avr/io.h>
+
+#define ISR(vector) void vector(void)
+#define cli() (SREG &= ~_BV(SREG_I))
+#define sei() (SREG |= _BV(SREG_I))
+
+#endif /* HOST_INTERRUPT_H_ */
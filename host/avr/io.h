@@ -0,0 +1,67 @@
+/*
+ * io.h
+ *
+ * Author: Arjun Srikanth
+ *
+ * Stand-in for the avr-libc header so modules which drive the hardware
+ * (such as serialio.c and snapshot.c) can be built into the host tests - build with
+ * -Ihost so this is found instead. Only the registers those modules use
+ * are here, as plain variables (defined in avr_sim.c) which a test can
+ * set and read. Interrupt handlers are ordinary functions the test calls
+ * itself (see avr_sim.h).
+ */
+
+#ifndef HOST_IO_H_
+#define HOST_IO_H_
+
+#include <stdint.h>
+
+#define _BV(bit) (1 << (bit))
+#define bit_is_set(sfr, bit) ((sfr) & _BV(bit))
+#define bit_is_clear(sfr, bit) (!bit_is_set(sfr, bit))
+
+// Status register (only the global interrupt enable is used)
+extern volatile uint8_t SREG;
+#define SREG_I 7
+
+// USART0 and USART1
+extern volatile uint8_t UCSR0A, UCSR0B, UCSR0C, UDR0;
+extern volatile uint8_t UCSR1A, UCSR1B, UCSR1C, UDR1;
+extern volatile uint16_t UBRR0, UBRR1;
+#define U2X0 1
+#define RXCIE0 7
+#define UDRIE0 5
+#define RXEN0 4
+#define TXEN0 3
+#define U2X1 1
+#define RXCIE1 7
+#define UDRIE1 5
+#define RXEN1 4
+#define TXEN1 3
+#define UCSZ11 2
+#define UCSZ10 1
+
+// EEPROM. EEDR is the byte of the simulated EEPROM at EEAR, so a read
+// (after setting EERE) sees the stored value and a write is stored at
+// once - EEPE never has to be waited for.
+#define E2END 0x3FF
+extern volatile uint16_t EEAR;
+extern volatile uint8_t EECR;
+extern uint8_t* avr_sim_eeprom;
+#define EEDR (avr_sim_eeprom[EEAR])
+#define EERIE 3
+#define EEMPE 2
+#define EEPE 1
+#define EERE 0
+
+// avr-libc's stdio.h can make a stream from a pair of functions, which
+// serialio.c uses for stdin and stdout. The host tests never use the
+// stream, but the functions are kept so they are still used.
+#define FDEV_SETUP_STREAM(put, get, flags) {0}; \
+	static const struct { \
+		int (*put_char)(char, FILE*); \
+		int (*get_char)(FILE*); \
+	} host_stream_functions __attribute__((unused)) = {put, get}
+#define _FDEV_SETUP_RW 3
+
+#endif /* HOST_IO_H_ */
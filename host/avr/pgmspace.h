@@ -0,0 +1,24 @@
+/*
+ * pgmspace.h
+ *
+ * Author: Arjun Srikanth
+ *
+ * Stand-in for the avr-libc header so modules which keep tables in program
+ * memory (such as board_library.c) can be built into the host tools and
+ * tests - build with -Ihost so this is found instead. On a PC program
+ * memory is just memory.
+ */
+
+#ifndef HOST_PGMSPACE_H_
+#define HOST_PGMSPACE_H_
+
+#include <stdint.h>
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(address) (*(const uint8_t*) (address))
+#define pgm_read_word(address) (*(const uint16_t*) (address))
+#define pgm_read_ptr(address) (*(void* const*) (address))
+#define memcpy_P memcpy
+
+#endif /* HOST_PGMSPACE_H_ */
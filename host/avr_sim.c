@@ -0,0 +1,85 @@
+/*
+ * avr_sim.c
+ *
+ * Author: Arjun Srikanth
+ */
+
+#include "avr_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <avr/io.h>
+#include <avr/eeprom.h>
+#include "../memory.h"
+
+volatile uint8_t SREG;
+volatile uint8_t UCSR0A, UCSR0B, UCSR0C, UDR0;
+volatile uint8_t UCSR1A, UCSR1B, UCSR1C, UDR1;
+volatile uint16_t UBRR0, UBRR1;
+volatile uint16_t EEAR;
+volatile uint8_t EECR;
+uint8_t* avr_sim_eeprom;
+
+void avr_sim_init(void) {
+	SREG = 0;
+	UCSR0A = UCSR0B = UCSR0C = UDR0 = 0;
+	UCSR1A = UCSR1B = UCSR1C = UDR1 = 0;
+	UBRR0 = UBRR1 = 0;
+	EEAR = 0;
+	EECR = 0;
+	if (!avr_sim_eeprom) {
+		avr_sim_eeprom = mmap(NULL, E2END + 1, PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+		if (avr_sim_eeprom == MAP_FAILED) {
+			perror("mmap");
+			exit(1);
+		}
+	}
+	memset(avr_sim_eeprom, 0xFF, E2END + 1);
+}
+
+// EEPROM addresses are passed as pointers, as in avr-libc
+static uint16_t eeprom_address(const void* address, size_t length) {
+	uintptr_t start = (uintptr_t) address;
+	if (start + length > E2END + 1) {
+		fprintf(stderr, "EEPROM access out of range: %lu\n",
+				(unsigned long) start);
+		exit(1);
+	}
+	return start;
+}
+
+uint8_t eeprom_read_byte(const uint8_t* address) {
+	return avr_sim_eeprom[eeprom_address(address, 1)];
+}
+
+uint16_t eeprom_read_word(const uint16_t* address) {
+	uint16_t start = eeprom_address(address, 2);
+	return avr_sim_eeprom[start] | (avr_sim_eeprom[start + 1] << 8);
+}
+
+void eeprom_read_block(void* data, const void* address, size_t length) {
+	memcpy(data, avr_sim_eeprom + eeprom_address(address, length), length);
+}
+
+void eeprom_update_byte(uint8_t* address, uint8_t value) {
+	avr_sim_eeprom[eeprom_address(address, 1)] = value;
+}
+
+void eeprom_update_word(uint16_t* address, uint16_t value) {
+	uint16_t start = eeprom_address(address, 2);
+	avr_sim_eeprom[start] = value & 0xFF;
+	avr_sim_eeprom[start + 1] = value >> 8;
+}
+
+void eeprom_update_block(const void* data, void* address, size_t length) {
+	memcpy(avr_sim_eeprom + eeprom_address(address, length), data, length);
+}
+
+// Modules register their buffers - there is no memory report to add them to
+void memory_register(const char* name, uint16_t size) {
+	(void) name;
+	(void) size;
+}
@@ -0,0 +1,30 @@
+/*
+ * avr_sim.h
+ *
+ * Author: Arjun Srikanth
+ *
+ * The parts of the microcontroller the host tests need (see avr/io.h).
+ * Build avr_sim.c into any test which uses the stand-in headers, and call
+ * avr_sim_init() first.
+ */
+
+#ifndef AVR_SIM_H_
+#define AVR_SIM_H_
+
+#include <stdint.h>
+
+// Clear the registers (interrupts are off) and erase the EEPROM (every
+// byte 0xFF). The EEPROM is shared with child processes, so a test can
+// fork() to stand in for the unit after a reset and see what was written
+// before it.
+void avr_sim_init(void);
+
+// Interrupt handlers of the modules under test - call them to stand in
+// for the interrupt happening
+void USART0_UDRE_vect(void);
+void USART0_RX_vect(void);
+void USART1_UDRE_vect(void);
+void USART1_RX_vect(void);
+void EE_READY_vect(void);
+
+#endif /* AVR_SIM_H_ */
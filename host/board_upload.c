@@ -0,0 +1,136 @@
+/*
+ * board_upload.c
+ *
+ * Author: Arjun Srikanth
+ *
+ * Host tool which uploads a board layout to an EEPROM slot of the game
+ * (see boards.h and remote.h). The layout file has HEIGHT lines of WIDTH
+ * game objects in hex (see game.h), top row first - the same way round as
+ * the layouts in game.c. Build and run with
+ *
+ *     cc -o board_upload host/board_upload.c frame.c
+ *     stty -F /dev/ttyUSB0 19200 raw -echo
+ *     ./board_upload /dev/ttyUSB0 0 board.txt
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../frame.h"
+#include "../game.h"
+#include "../boards.h"
+#include "../remote.h"
+
+static const char* status_names[] = {
+	"OK", "bad slot", "upload not started", "wrong number of entries",
+	"bad CRC", "bad square", "start or finish missing",
+	"unmatched snake or ladder"
+};
+
+// Send a command and wait for the board status reply (skipping anything
+// else the game sends). Returns the status, or -1 if the port closed.
+static int send_command(int port, uint8_t type, const uint8_t* payload,
+		uint8_t length) {
+	uint8_t frame[FRAME_MAX_SIZE];
+	uint8_t size = frame_build(frame, type, payload, length);
+	if (write(port, frame, size) != size) {
+		return -1;
+	}
+	FrameParser parser;
+	frame_parser_init(&parser);
+	uint8_t byte;
+	while (read(port, &byte, 1) == 1) {
+		if (frame_parser_feed(&parser, byte) && parser.type == REMOTE_BOARD_STATUS
+				&& parser.length == 1) {
+			return parser.payload[0];
+		}
+	}
+	return -1;
+}
+
+static int check_status(int status, const char* step) {
+	if (status == BOARD_OK) {
+		return 0;
+	}
+	if (status < 0) {
+		fprintf(stderr, "%s: no reply from the game\n", step);
+	} else if (status < (int) (sizeof(status_names) / sizeof(status_names[0]))) {
+		fprintf(stderr, "%s: %s\n", step, status_names[status]);
+	} else {
+		fprintf(stderr, "%s: error %d\n", step, status);
+	}
+	return 1;
+}
+
+int main(int argc, char** argv) {
+	if (argc != 4) {
+		fprintf(stderr, "usage: %s port slot layout-file\n", argv[0]);
+		return 2;
+	}
+	FILE* layout = fopen(argv[3], "r");
+	if (!layout) {
+		perror(argv[3]);
+		return 1;
+	}
+	// Non-empty squares, as board entries
+	uint8_t entries[2 * BOARD_MAX_ENTRIES];
+	uint8_t num_entries = 0;
+	for (int row = HEIGHT - 1; row >= 0; row--) {
+		for (int x = 0; x < WIDTH; x++) {
+			unsigned object;
+			if (fscanf(layout, "%x", &object) != 1 || object > 0xFF) {
+				fprintf(stderr, "%s: expected %d rows of %d objects\n",
+						argv[3], HEIGHT, WIDTH);
+				return 1;
+			}
+			if (object == EMPTY_SQUARE) {
+				continue;
+			}
+			if (num_entries == BOARD_MAX_ENTRIES) {
+				fprintf(stderr, "%s: more than %d squares used\n", argv[3],
+						BOARD_MAX_ENTRIES);
+				return 1;
+			}
+			entries[2 * num_entries] = x | (row << 4);
+			entries[2 * num_entries + 1] = object;
+			num_entries++;
+		}
+	}
+	fclose(layout);
+
+	int port = open(argv[1], O_RDWR | O_NOCTTY);
+	if (port < 0) {
+		perror(argv[1]);
+		return 1;
+	}
+
+	uint8_t start[2] = {atoi(argv[2]), num_entries};
+	if (check_status(send_command(port, REMOTE_BOARD_START, start, 2), "start")) {
+		return 1;
+	}
+	uint16_t crc = 0xFFFF;
+	for (int i = 0; i < 2 * num_entries; i++) {
+		crc = frame_crc16_update(crc, entries[i]);
+	}
+	for (int sent = 0; sent < 2 * num_entries; sent += FRAME_MAX_PAYLOAD) {
+		int length = 2 * num_entries - sent;
+		if (length > FRAME_MAX_PAYLOAD) {
+			length = FRAME_MAX_PAYLOAD;
+		}
+		if (check_status(send_command(port, REMOTE_BOARD_DATA, &entries[sent],
+				length), "data")) {
+			return 1;
+		}
+	}
+	uint8_t finish[2] = {crc & 0xFF, crc >> 8};
+	if (check_status(send_command(port, REMOTE_BOARD_FINISH, finish, 2), "finish")) {
+		return 1;
+	}
+	printf("Board of %d squares stored as board %d\n", num_entries,
+			BUILT_IN_BOARDS + 1 + atoi(argv[2]));
+	close(port);
+	return 0;
+}
@@ -0,0 +1,164 @@
+/*
+ * engine.c
+ *
+ * Author: Arjun Srikanth
+ */
+
+#include "engine.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "../frame.h"
+#include "../board_library.h"
+
+bool engine_load_library_board(Engine* engine, uint8_t board_number) {
+	return board_library_load(board_number, engine->board);
+}
+
+bool engine_load_layout(Engine* engine, FILE* layout) {
+	for (int row = HEIGHT - 1; row >= 0; row--) {
+		for (int x = 0; x < WIDTH; x++) {
+			unsigned object;
+			if (fscanf(layout, "%x", &object) != 1 || object > 0xFF) {
+				return false;
+			}
+			engine->board[x][row] = object;
+		}
+	}
+	return true;
+}
+
+void engine_set_state(Engine* engine, const uint8_t* state) {
+	engine->two_player = (state[REMOTE_P2_POSITION] != 0xFF);
+	engine->x[0] = state[REMOTE_P1_POSITION] & 0x0F;
+	engine->y[0] = state[REMOTE_P1_POSITION] >> 4;
+	// Player 2 stays at the start in a one player game
+	engine->x[1] = engine->two_player ? (state[REMOTE_P2_POSITION] & 0x0F) : 0;
+	engine->y[1] = engine->two_player ? (state[REMOTE_P2_POSITION] >> 4) : 0;
+	engine->moves[0] = state[REMOTE_P1_MOVES];
+	engine->moves[1] = state[REMOTE_P2_MOVES];
+	engine->turn = state[REMOTE_TURN];
+	engine->dice = state[REMOTE_DICE];
+}
+
+void engine_get_state(const Engine* engine, uint8_t* state) {
+	state[REMOTE_P1_POSITION] = engine->x[0] | (engine->y[0] << 4);
+	state[REMOTE_P2_POSITION] = 0xFF;
+	state[REMOTE_P1_MOVES] = engine->moves[0];
+	state[REMOTE_P2_MOVES] = 0;
+	state[REMOTE_TURN] = 0;
+	if (engine->two_player) {
+		state[REMOTE_P2_POSITION] = engine->x[1] | (engine->y[1] << 4);
+		state[REMOTE_P2_MOVES] = engine->moves[1];
+		state[REMOTE_TURN] = engine->turn;
+	}
+	state[REMOTE_GAME_OVER] = engine_game_over(engine);
+	state[REMOTE_DICE] = engine->dice;
+}
+
+uint16_t engine_state_hash(const Engine* engine) {
+	uint8_t state[REMOTE_STATE_SIZE];
+	engine_get_state(engine, state);
+	return frame_crc16(state, REMOTE_STATE_SIZE);
+}
+
+void engine_srand(Engine* engine, uint16_t seed) {
+	engine->rand_next = seed;
+}
+
+// The avr-libc rand() - the "minimal standard" generator, x * 16807 mod
+// 2^31 - 1, worked out without overflowing 32 bits, and cut down to
+// RAND_MAX (0x7FFF on the AVR)
+static int16_t avr_rand(uint32_t* next) {
+	int32_t x = *next;
+	if (x == 0) {
+		x = 123459876L;
+	}
+	int32_t hi = x / 127773L;
+	int32_t lo = x % 127773L;
+	x = 16807L * lo - 2836L * hi;
+	if (x < 0) {
+		x += 0x7FFFFFFFL;
+	}
+	*next = x;
+	return x % (0x7FFFUL + 1);
+}
+
+uint8_t engine_roll_dice(Engine* engine) {
+	return avr_rand(&engine->rand_next) % 6 + 1;
+}
+
+// One square forward along the path (see step_forward() in game.c)
+static void step_forward(int8_t* x, int8_t* y) {
+	if (*y % 2 == 0) {
+		if (*x == WIDTH - 1) {
+			*y += 1;
+		} else {
+			*x += 1;
+		}
+	} else {
+		if (*x == 0) {
+			*y += 1;
+		} else {
+			*x -= 1;
+		}
+	}
+}
+
+// Move the player to the end of the snake or ladder they are on the start
+// of, if any
+static void follow_link(Engine* engine, uint8_t player) {
+	uint8_t object = engine->board[engine->x[player]][engine->y[player]];
+	uint8_t type = object & 0xF0;
+	uint8_t end_type;
+	if (type == SNAKE_START) {
+		end_type = SNAKE_END;
+	} else if (type == LADDER_START) {
+		end_type = LADDER_END;
+	} else {
+		return;
+	}
+	for (int8_t x = 0; x < WIDTH; x++) {
+		for (int8_t y = 0; y < HEIGHT; y++) {
+			if (engine->board[x][y] == (end_type | (object & 0x0F))) {
+				engine->x[player] = x;
+				engine->y[player] = y;
+				return;
+			}
+		}
+	}
+}
+
+void engine_take_turn(Engine* engine, uint8_t spaces) {
+	uint8_t player = engine->two_player ? engine->turn : 0;
+	for (uint8_t i = 0; i < spaces; i++) {
+		if (engine->x[player] == 0 && engine->y[player] == HEIGHT - 1) {
+			break;
+		}
+		step_forward(&engine->x[player], &engine->y[player]);
+	}
+	follow_link(engine, player);
+	engine->moves[player]++;
+	if (engine->two_player) {
+		engine->turn = !engine->turn;
+	}
+}
+
+uint8_t engine_game_over(const Engine* engine) {
+	for (uint8_t player = 0; player < 2; player++) {
+		if ((engine->board[engine->x[player]][engine->y[player]] & 0xF0) == FINISH_LINE) {
+			return player + 1;
+		}
+	}
+	return 0;
+}
+
+uint8_t engine_roll_turns(Engine* engine, uint8_t turns) {
+	uint8_t played = 0;
+	while (played < turns && !engine_game_over(engine)) {
+		engine->dice = engine_roll_dice(engine);
+		engine_take_turn(engine, engine->dice);
+		played++;
+	}
+	return played;
+}
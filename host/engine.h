@@ -0,0 +1,62 @@
+/*
+ * engine.h
+ *
+ * Author: Arjun Srikanth
+ *
+ * Model of the game rules on a PC, used to check runs played through the
+ * real game by a test rig (see remote.h). It follows move_player_n(),
+ * snake_ladder_func(), is_game_over() and take_turn() in the game, and
+ * rolls dice with the same generator as the avr-libc rand(), so the same
+ * seed gives the same rolls. The state and its hash are made the same way
+ * as the game's REMOTE_RESULT replies.
+ */
+
+#ifndef ENGINE_H_
+#define ENGINE_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "../game.h"
+#include "../remote.h"
+
+typedef struct {
+	uint8_t board[WIDTH][HEIGHT];
+	bool two_player;
+	int8_t x[2];
+	int8_t y[2];
+	uint8_t moves[2];
+	uint8_t turn;			// 0 for player 1, 1 for player 2
+	uint8_t dice;
+	uint32_t rand_next;		// state of rand()
+} Engine;
+
+// Load a board from the board library (see board_library.h). Returns
+// false if there is no such board.
+bool engine_load_library_board(Engine* engine, uint8_t board_number);
+
+// Load a board from a layout file in the format used by board_upload.
+// Returns false if the file can't be read.
+bool engine_load_layout(Engine* engine, FILE* layout);
+
+// Take the positions, moves, turn and dice from a state reported by the
+// game (REMOTE_STATE_SIZE bytes - see remote.h)
+void engine_set_state(Engine* engine, const uint8_t* state);
+void engine_get_state(const Engine* engine, uint8_t* state);
+uint16_t engine_state_hash(const Engine* engine);
+
+// The same as srand() and rand() % 6 + 1 in the game
+void engine_srand(Engine* engine, uint16_t seed);
+uint8_t engine_roll_dice(Engine* engine);
+
+// Play a turn of the given number of spaces
+void engine_take_turn(Engine* engine, uint8_t spaces);
+
+// 0 if the game isn't over, otherwise the player who won (1 or 2)
+uint8_t engine_game_over(const Engine* engine);
+
+// Roll the dice and take turns (as REMOTE_ROLL does) until turns have been
+// played or the game is over. Returns the number of turns played.
+uint8_t engine_roll_turns(Engine* engine, uint8_t turns);
+
+#endif /* ENGINE_H_ */
@@ -0,0 +1,138 @@
+/*
+ * link_peer.c
+ *
+ * Author: Arjun Srikanth
+ *
+ * Runs one end of the link between two units (see link.h) on a PC, so the
+ * protocol can be tested without the hardware. Two of these joined by a
+ * pty pair stand in for two units joined by a cable:
+ *
+ *     cc -o link_peer host/link_peer.c link.c frame.c
+ *     socat pty,raw,echo=0,link=/tmp/unit_a pty,raw,echo=0,link=/tmp/unit_b &
+ *     ./link_peer /tmp/unit_a invite 200 &
+ *     ./link_peer /tmp/unit_b join 200
+ *
+ * Each peer plays the given number of its own turns with random dice
+ * rolls, keeping a simple model of the game (how far each player has
+ * moved) which is hashed after every move. Adding a fourth argument makes
+ * that peer's model go wrong after that many turns, which the other peer
+ * should detect. A port of "-" uses standard input.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/select.h>
+#include "../link.h"
+#include "../frame.h"
+
+static int port;
+
+// Model of the game - distance moved and turns taken by each player, and
+// whose turn it is (0 or 1)
+static uint8_t model[5];
+#define MODEL_TURN 4
+
+void link_transport_write(const uint8_t* data, uint8_t length) {
+	if (write(port, data, length) != length) {
+		perror("write");
+		exit(1);
+	}
+}
+
+static uint32_t now_ms(void) {
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec * 1000 + time.tv_nsec / 1000000;
+}
+
+static void take_turn(uint8_t spaces) {
+	uint8_t player = model[MODEL_TURN];
+	model[player] += spaces;
+	model[2 + player]++;
+	model[MODEL_TURN] = !player;
+}
+
+static const char* state_names[] = {"off", "inviting", "connected",
+		"out of sync", "lost"};
+
+int main(int argc, char** argv) {
+	if (argc < 4 || (strcmp(argv[2], "invite") && strcmp(argv[2], "join"))) {
+		fprintf(stderr, "usage: %s port invite|join turns [bad-turn]\n", argv[0]);
+		return 2;
+	}
+	port = strcmp(argv[1], "-") ? open(argv[1], O_RDWR | O_NOCTTY) : 0;
+	if (port < 0) {
+		perror(argv[1]);
+		return 1;
+	}
+	struct termios settings;
+	if (tcgetattr(port, &settings) == 0) {
+		cfmakeraw(&settings);
+		tcsetattr(port, TCSANOW, &settings);
+	}
+	int turns = atoi(argv[3]);
+	int bad_turn = (argc > 4) ? atoi(argv[4]) : -1;
+	srand(getpid());
+
+	link_init();
+	if (!strcmp(argv[2], "invite")) {
+		link_invite(1, rand(), now_ms());
+	}
+
+	int my_turns = 0, their_turns = 0;
+	uint32_t start_time = 0;
+	while (link_state() == LINK_OFF || link_state() == LINK_INVITING
+			|| (link_state() == LINK_CONNECTED
+				&& (my_turns < turns || their_turns < turns))) {
+		fd_set fds;
+		FD_ZERO(&fds);
+		FD_SET(port, &fds);
+		struct timeval timeout = {0, 10000};
+		if (select(port + 1, &fds, 0, 0, &timeout) > 0) {
+			uint8_t buf[64];
+			ssize_t count = read(port, buf, sizeof(buf));
+			for (ssize_t i = 0; i < count; i++) {
+				link_receive(buf[i], now_ms());
+			}
+		}
+		link_poll(now_ms());
+		if (link_state() != LINK_CONNECTED) {
+			continue;
+		}
+		if (!start_time) {
+			start_time = now_ms();
+			link_send_board(0x1234);
+		}
+
+		LinkTurn turn;
+		while (link_get_turn(&turn)) {
+			take_turn(turn.value);
+			their_turns++;
+			link_check_hash(turn.hash, frame_crc16(model, sizeof(model)));
+		}
+		bool my_turn = (model[MODEL_TURN] == 0) == link_is_player_1();
+		if (my_turn && my_turns < turns) {
+			uint8_t spaces = 1 + rand() % 6;
+			take_turn(spaces);
+			if (++my_turns == bad_turn) {
+				model[0]++;
+			}
+			link_send_turn(LINK_ACTION_ROLL, spaces, frame_crc16(model, sizeof(model)));
+		}
+	}
+
+	uint32_t elapsed = now_ms() - start_time;
+	printf("%s: player %d, %d turns each way in %u ms, link %s\n", argv[2],
+			link_is_player_1() ? 1 : 2, my_turns, elapsed,
+			state_names[link_state()]);
+	// Give the other peer time to finish before the port goes away
+	usleep(100000);
+	return link_state() == LINK_CONNECTED ? 0 : 1;
+}
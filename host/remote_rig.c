@@ -0,0 +1,165 @@
+/*
+ * remote_rig.c
+ *
+ * Author: Arjun Srikanth
+ *
+ * Test rig which drives a game in progress through the remote control
+ * protocol (see remote.h) and checks every batch of turns against the
+ * host model of the game (see engine.h). The board is a board number from
+ * the library, or the layout file a stored board was uploaded from (see
+ * board_upload.c). Build and run with
+ *
+ *     cc -Ihost -o remote_rig host/remote_rig.c host/engine.c frame.c board_library.c
+ *     stty -F /dev/ttyUSB0 19200 raw -echo
+ *     ./remote_rig /dev/ttyUSB0 1 1234 5000
+ *
+ * to play up to 5000 turns of board 1 with dice seeded with 1234. Start a
+ * game on the unit first, and leave the dice alone while the rig runs -
+ * rolling them from the game uses up random numbers the model doesn't
+ * know about.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../frame.h"
+#include "../remote.h"
+#include "../board_library.h"
+#include "engine.h"
+
+// Turns rolled in each batch (at most 255)
+#define BATCH_TURNS 100
+
+static int port;
+
+typedef struct {
+	uint8_t turns;
+	uint16_t hash;
+	uint8_t state[REMOTE_STATE_SIZE];
+} RigResult;
+
+// Send a command and wait for the result (skipping anything else the game
+// sends, such as terminal output). Returns false if the port closed.
+static bool send_command(uint8_t type, const uint8_t* payload, uint8_t length,
+		RigResult* result) {
+	uint8_t frame[FRAME_MAX_SIZE];
+	uint8_t size = frame_build(frame, type, payload, length);
+	if (write(port, frame, size) != size) {
+		return false;
+	}
+	FrameParser parser;
+	frame_parser_init(&parser);
+	uint8_t byte;
+	while (read(port, &byte, 1) == 1) {
+		if (frame_parser_feed(&parser, byte) && parser.type == REMOTE_RESULT
+				&& parser.length == 3 + REMOTE_STATE_SIZE) {
+			result->turns = parser.payload[0];
+			result->hash = parser.payload[1] | (parser.payload[2] << 8);
+			memcpy(result->state, &parser.payload[3], REMOTE_STATE_SIZE);
+			return true;
+		}
+	}
+	return false;
+}
+
+static void print_state(const char* name, const uint8_t* state) {
+	fprintf(stderr, "%s:", name);
+	for (uint8_t i = 0; i < REMOTE_STATE_SIZE; i++) {
+		fprintf(stderr, " %02X", state[i]);
+	}
+	fprintf(stderr, "\n");
+}
+
+int main(int argc, char** argv) {
+	if (argc != 5) {
+		fprintf(stderr, "usage: %s port board seed turns\n", argv[0]);
+		return 2;
+	}
+	Engine engine;
+	char* end;
+	long board_number = strtol(argv[2], &end, 10);
+	if (*end == '\0') {
+		if (!engine_load_library_board(&engine, board_number)) {
+			fprintf(stderr, "%s: no such board in the library (1 to %d)\n",
+					argv[2], BOARD_LIBRARY_SIZE);
+			return 1;
+		}
+	} else {
+		FILE* layout = fopen(argv[2], "r");
+		if (!layout || !engine_load_layout(&engine, layout)) {
+			fprintf(stderr, "%s: expected %d rows of %d objects\n", argv[2],
+					HEIGHT, WIDTH);
+			return 1;
+		}
+		fclose(layout);
+	}
+	uint16_t seed = atoi(argv[3]);
+	long turns_wanted = atol(argv[4]);
+
+	port = open(argv[1], O_RDWR | O_NOCTTY);
+	if (port < 0) {
+		perror(argv[1]);
+		return 1;
+	}
+
+	// Start the model from wherever the game is now
+	RigResult result;
+	uint8_t no_turns = 0;
+	uint8_t seed_bytes[2] = {seed & 0xFF, seed >> 8};
+	if (!send_command(REMOTE_ROLL, &no_turns, 1, &result)
+			|| !send_command(REMOTE_SEED, seed_bytes, 2, &result)) {
+		fprintf(stderr, "no reply from the game\n");
+		return 1;
+	}
+	engine_set_state(&engine, result.state);
+	engine_srand(&engine, seed);
+	if (engine_state_hash(&engine) != result.hash) {
+		fprintf(stderr, "game and model disagree before any turns\n");
+		return 1;
+	}
+
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	long turns_played = 0;
+	while (turns_played < turns_wanted && !engine_game_over(&engine)) {
+		uint8_t batch = BATCH_TURNS;
+		if (turns_wanted - turns_played < BATCH_TURNS) {
+			batch = turns_wanted - turns_played;
+		}
+		if (!send_command(REMOTE_ROLL, &batch, 1, &result)) {
+			fprintf(stderr, "no reply from the game\n");
+			return 1;
+		}
+		uint8_t model_turns = engine_roll_turns(&engine, batch);
+		if (result.turns != model_turns || result.hash != engine_state_hash(&engine)) {
+			uint8_t model_state[REMOTE_STATE_SIZE];
+			engine_get_state(&engine, model_state);
+			fprintf(stderr, "mismatch after turn %ld (game played %u turns, "
+					"model %u)\n", turns_played, result.turns, model_turns);
+			print_state("game ", result.state);
+			print_state("model", model_state);
+			return 1;
+		}
+		turns_played += model_turns;
+	}
+
+	struct timespec finish;
+	clock_gettime(CLOCK_MONOTONIC, &finish);
+	double seconds = (finish.tv_sec - start.tv_sec)
+			+ (finish.tv_nsec - start.tv_nsec) / 1e9;
+	printf("%ld turns matched the model", turns_played);
+	if (seconds > 0) {
+		printf(" (%.0f turns a minute)", turns_played * 60 / seconds);
+	}
+	if (engine_game_over(&engine)) {
+		printf(" - player %u won", engine_game_over(&engine));
+	}
+	printf("\n");
+	close(port);
+	return 0;
+}
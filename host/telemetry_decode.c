@@ -0,0 +1,119 @@
+/*
+ * telemetry_decode.c
+ *
+ * Author: Arjun Srikanth
+ *
+ * Host tool which decodes the telemetry stream (see telemetry.h) from the
+ * game's serial port and prints the game state each time it changes.
+ * Terminal text mixed in with the frames is skipped. Build and run with
+ *
+ *     cc -o telemetry_decode host/telemetry_decode.c frame.c
+ *     stty -F /dev/ttyUSB0 19200 raw -echo
+ *     ./telemetry_decode < /dev/ttyUSB0
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "../frame.h"
+#include "../telemetry.h"
+
+static uint8_t state[TELEMETRY_STATE_SIZE];
+static bool have_snapshot;
+
+static void print_position(const char* name, uint8_t position) {
+	if (position == TELEMETRY_NO_PLAYER) {
+		return;
+	}
+	printf(" %s=(%u,%u)", name, position & 0x0F, position >> 4);
+}
+
+static unsigned get_time(uint8_t field) {
+	uint8_t offset = TELEMETRY_FIELD_OFFSET(field);
+	return state[offset] | (state[offset + 1] << 8);
+}
+
+static void print_state(void) {
+	uint8_t flags = state[TELEMETRY_FLAGS];
+	printf("%s", (flags & TELEMETRY_TWO_PLAYER) ? "2P" : "1P");
+	print_position("p1", state[TELEMETRY_P1_POSITION]);
+	print_position("p2", state[TELEMETRY_P2_POSITION]);
+	printf(" dice=%u%s moves=%u", state[TELEMETRY_DICE],
+			(flags & TELEMETRY_ROLLING) ? "(rolling)" : "",
+			state[TELEMETRY_MOVES]);
+	if (flags & TELEMETRY_TIMED) {
+		unsigned p1_time = get_time(TELEMETRY_P1_TIME);
+		printf(" p1_time=%u.%u", p1_time / 10, p1_time % 10);
+		if (flags & TELEMETRY_TWO_PLAYER) {
+			unsigned p2_time = get_time(TELEMETRY_P2_TIME);
+			printf(" p2_time=%u.%u", p2_time / 10, p2_time % 10);
+		}
+	}
+	if (flags & TELEMETRY_TWO_PLAYER) {
+		printf(" turn=%s", (flags & TELEMETRY_P2_TURN) ? "p2" : "p1");
+	}
+	if (flags & TELEMETRY_GAME_OVER) {
+		if (flags & TELEMETRY_P1_WINS) {
+			printf(" GAME OVER - player 1 wins");
+		} else if (flags & TELEMETRY_P2_WINS) {
+			printf(" GAME OVER - player 2 wins");
+		} else {
+			printf(" GAME OVER - no winner");
+		}
+	}
+	printf("\n");
+	fflush(stdout);
+}
+
+// Apply a delta frame to the state. Returns false if the frame doesn't
+// match the fields it says it has.
+static bool apply_delta(const uint8_t* payload, uint8_t length) {
+	uint8_t changed = payload[0];
+	uint8_t pos = 1;
+	for (uint8_t field = 0; field < TELEMETRY_NUM_FIELDS; field++) {
+		if (!(changed & (1 << field))) {
+			continue;
+		}
+		uint8_t offset = TELEMETRY_FIELD_OFFSET(field);
+		for (uint8_t i = 0; i < TELEMETRY_FIELD_SIZE(field); i++) {
+			if (pos >= length) {
+				return false;
+			}
+			state[offset + i] = payload[pos++];
+		}
+	}
+	return pos == length;
+}
+
+int main(void) {
+	FrameParser parser;
+	frame_parser_init(&parser);
+	unsigned long bytes = 0, frames = 0;
+
+	int c;
+	while ((c = getchar()) != EOF) {
+		bytes++;
+		if (!frame_parser_feed(&parser, (uint8_t) c)) {
+			continue;
+		}
+		frames++;
+		if (parser.type == TELEMETRY_SNAPSHOT
+				&& parser.length == TELEMETRY_STATE_SIZE) {
+			for (uint8_t i = 0; i < TELEMETRY_STATE_SIZE; i++) {
+				state[i] = parser.payload[i];
+			}
+			have_snapshot = true;
+			print_state();
+		} else if (parser.type == TELEMETRY_DELTA && parser.length > 0
+				&& have_snapshot) {
+			// Deltas before the first snapshot can't be used
+			if (apply_delta(parser.payload, parser.length)) {
+				print_state();
+			} else {
+				have_snapshot = false;
+			}
+		}
+	}
+	fprintf(stderr, "%lu frames in %lu bytes\n", frames, bytes);
+	return 0;
+}
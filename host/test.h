@@ -0,0 +1,46 @@
+/*
+ * test.h
+ *
+ * Author: Arjun Srikanth
+ *
+ * Checks for the host tests. Each test is a program whose main() makes
+ * its checks and returns test_summary(), so it exits with a failure
+ * status if any check failed.
+ */
+
+#ifndef TEST_H_
+#define TEST_H_
+
+#include <stdio.h>
+
+static unsigned test_checks;
+static unsigned test_failures;
+
+#define CHECK(condition) do { \
+		test_checks++; \
+		if (!(condition)) { \
+			test_failures++; \
+			fprintf(stderr, "%s:%d: check failed: %s\n", \
+					__FILE__, __LINE__, #condition); \
+		} \
+	} while (0)
+
+// Like CHECK(actual == expected), but prints both values if they differ
+#define CHECK_EQUAL(actual, expected) do { \
+		long actual_value = (long) (actual); \
+		long expected_value = (long) (expected); \
+		test_checks++; \
+		if (actual_value != expected_value) { \
+			test_failures++; \
+			fprintf(stderr, "%s:%d: %s is %ld, expected %ld\n", \
+					__FILE__, __LINE__, #actual, actual_value, \
+					expected_value); \
+		} \
+	} while (0)
+
+static inline int test_summary(const char* name) {
+	printf("%s: %u checks, %u failed\n", name, test_checks, test_failures);
+	return test_failures ? 1 : 0;
+}
+
+#endif /* TEST_H_ */
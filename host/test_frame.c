@@ -0,0 +1,163 @@
+/*
+ * test_frame.c
+ *
+ * Author: Arjun Srikanth
+ *
+ * Host tests of the CRCs and the frame parser (see frame.h). Build and run
+ * from the top directory with
+ *
+ *     cc -Ihost -o test_frame host/test_frame.c frame.c
+ *     ./test_frame
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "../frame.h"
+#include "test.h"
+
+// Feed bytes to the parser, returning how many frames were completed. The
+// last frame is left in the parser.
+static int feed(FrameParser* parser, const uint8_t* bytes, int count) {
+	int frames = 0;
+	for (int i = 0; i < count; i++) {
+		if (frame_parser_feed(parser, bytes[i])) {
+			frames++;
+		}
+	}
+	return frames;
+}
+
+static void test_crcs(void) {
+	// Standard check values of CRC-8 (polynomial 0x07) and
+	// CRC-16/CCITT-FALSE for the ASCII digits 1 to 9
+	const uint8_t digits[] = "123456789";
+	uint8_t crc = 0;
+	for (int i = 0; i < 9; i++) {
+		crc = frame_crc_update(crc, digits[i]);
+	}
+	CHECK_EQUAL(crc, 0xF4);
+	CHECK_EQUAL(frame_crc16(digits, 9), 0x29B1);
+	CHECK_EQUAL(frame_crc16(digits, 0), 0xFFFF);
+}
+
+static void test_build(void) {
+	const uint8_t payload[] = {0x01, FRAME_SYNC, 0xFF};
+	uint8_t frame[FRAME_MAX_SIZE];
+	uint8_t size = frame_build(frame, 0x42, payload, 3);
+	CHECK_EQUAL(size, 3 + FRAME_OVERHEAD);
+	CHECK_EQUAL(frame[0], FRAME_SYNC);
+	CHECK_EQUAL(frame[1], 0x42);
+	CHECK_EQUAL(frame[2], 3);
+	CHECK(memcmp(frame + 3, payload, 3) == 0);
+	uint8_t crc = 0;
+	for (int i = 1; i < size - 1; i++) {
+		crc = frame_crc_update(crc, frame[i]);
+	}
+	CHECK_EQUAL(frame[size - 1], crc);
+}
+
+static void test_round_trip(void) {
+	uint8_t payload[FRAME_MAX_PAYLOAD];
+	for (int i = 0; i < FRAME_MAX_PAYLOAD; i++) {
+		payload[i] = i * 37;
+	}
+	FrameParser parser;
+	frame_parser_init(&parser);
+	CHECK(frame_parser_idle(&parser));
+	for (int length = 0; length <= FRAME_MAX_PAYLOAD; length++) {
+		uint8_t frame[FRAME_MAX_SIZE];
+		uint8_t size = frame_build(frame, length, payload, length);
+		// Only the last byte completes the frame
+		CHECK_EQUAL(feed(&parser, frame, size - 1), 0);
+		CHECK(frame_parser_feed(&parser, frame[size - 1]));
+		CHECK_EQUAL(parser.type, length);
+		CHECK_EQUAL(parser.length, length);
+		CHECK(memcmp(parser.payload, payload, length) == 0);
+		CHECK(frame_parser_idle(&parser));
+	}
+}
+
+static void test_mixed_with_text(void) {
+	uint8_t stream[64];
+	int size = 0;
+	const char* text = "\x1b[2J\x1b[HScore: 10\r\n";
+	memcpy(stream, text, strlen(text));
+	size += strlen(text);
+	const uint8_t payload[] = {7, 8};
+	size += frame_build(stream + size, 0x10, payload, 2);
+	memcpy(stream + size, text, strlen(text));
+	size += strlen(text);
+	size += frame_build(stream + size, 0x11, 0, 0);
+
+	FrameParser parser;
+	frame_parser_init(&parser);
+	CHECK_EQUAL(feed(&parser, stream, size), 2);
+	CHECK_EQUAL(parser.type, 0x11);
+	CHECK_EQUAL(parser.length, 0);
+}
+
+static void test_bad_frames(void) {
+	const uint8_t payload[] = {1, 2, 3, 4};
+	uint8_t good[FRAME_MAX_SIZE];
+	uint8_t good_size = frame_build(good, 0x20, payload, 4);
+	FrameParser parser;
+	frame_parser_init(&parser);
+
+	// Every single bit error is caught by the CRC
+	for (int i = 1; i < good_size; i++) {
+		for (int bit = 0; bit < 8; bit++) {
+			uint8_t bad[FRAME_MAX_SIZE];
+			memcpy(bad, good, good_size);
+			bad[i] ^= 1 << bit;
+			frame_parser_init(&parser);
+			bool completed = false;
+			for (int j = 0; j < good_size; j++) {
+				if (frame_parser_feed(&parser, bad[j])
+						&& parser.type == 0x20 && parser.length == 4
+						&& memcmp(parser.payload, payload, 4) == 0) {
+					completed = true;
+				}
+			}
+			CHECK(!completed);
+		}
+	}
+
+	// A frame cut off part way through (its sync byte lost, say) doesn't
+	// stop the next one being found
+	uint8_t stream[2 * FRAME_MAX_SIZE];
+	memcpy(stream, good + 1, good_size - 1);
+	memcpy(stream + good_size - 1, good, good_size);
+	frame_parser_init(&parser);
+	CHECK_EQUAL(feed(&parser, stream, 2 * good_size - 1), 1);
+	CHECK(memcmp(parser.payload, payload, 4) == 0);
+
+	// A bad CRC which is the sync byte of the next frame
+	uint8_t resync[] = {FRAME_SYNC, 0x20, 0, FRAME_SYNC};
+	if (frame_crc_update(frame_crc_update(0, 0x20), 0) == FRAME_SYNC) {
+		resync[1] = 0x21;
+	}
+	frame_parser_init(&parser);
+	CHECK_EQUAL(feed(&parser, resync, 4), 0);
+	CHECK_EQUAL(feed(&parser, good + 1, good_size - 1), 1);
+
+	// Too long to be a frame, where the length byte is really a sync
+	uint8_t too_long[] = {FRAME_SYNC, 0x20, FRAME_MAX_PAYLOAD + 1};
+	frame_parser_init(&parser);
+	CHECK_EQUAL(feed(&parser, too_long, 3), 0);
+	CHECK(frame_parser_idle(&parser));
+	uint8_t lost_sync[] = {FRAME_SYNC, 0x20};
+	frame_parser_init(&parser);
+	feed(&parser, lost_sync, 2);
+	CHECK_EQUAL(feed(&parser, good, good_size), 1);
+}
+
+int main(void) {
+	test_crcs();
+	test_build();
+	test_round_trip();
+	test_mixed_with_text();
+	test_bad_frames();
+	return test_summary("test_frame");
+}
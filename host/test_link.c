@@ -0,0 +1,337 @@
+/*
+ * test_link.c
+ *
+ * Author: Arjun Srikanth
+ *
+ * Host tests of the link protocol (see link.h). The test plays the other
+ * unit, sending it frames and checking the frames it sends back. Build and
+ * run from the top directory with
+ *
+ *     cc -Ihost -o test_link host/test_link.c link.c frame.c
+ *     ./test_link
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "../frame.h"
+#include "../link.h"
+#include "test.h"
+
+// Frames sent by the link since the last clear_sent()
+#define MAX_SENT 8
+static FrameParser sent_parser;
+static FrameParser sent[MAX_SENT];
+static int sent_count;
+static int bad_bytes;
+
+void link_transport_write(const uint8_t* data, uint8_t length) {
+	for (uint8_t i = 0; i < length; i++) {
+		if (frame_parser_feed(&sent_parser, data[i])) {
+			if (sent_count < MAX_SENT) {
+				sent[sent_count] = sent_parser;
+			}
+			sent_count++;
+		} else if (frame_parser_idle(&sent_parser)) {
+			bad_bytes++;
+		}
+	}
+}
+
+static void clear_sent(void) {
+	sent_count = 0;
+}
+
+// Send the link a frame from the other unit
+static void receive(uint8_t type, const uint8_t* payload, uint8_t length,
+		uint32_t time) {
+	uint8_t frame[FRAME_MAX_SIZE];
+	uint8_t size = frame_build(frame, type, payload, length);
+	for (uint8_t i = 0; i < size; i++) {
+		link_receive(frame[i], time);
+	}
+}
+
+static void receive_invite(uint8_t nonce, uint8_t board, uint32_t time) {
+	uint8_t payload[3] = {LINK_VERSION, nonce, board};
+	receive(LINK_INVITE, payload, 3, time);
+}
+
+static void receive_turn(uint8_t sequence, uint8_t action, uint8_t value,
+		uint16_t hash, uint32_t time) {
+	uint8_t payload[5] = {sequence, action, value, hash & 0xFF, hash >> 8};
+	receive(LINK_TURN, payload, 5, time);
+}
+
+// Check the only frame sent since the last clear_sent() and clear it
+static void check_sent(uint8_t type, const uint8_t* payload, uint8_t length) {
+	CHECK_EQUAL(sent_count, 1);
+	CHECK_EQUAL(sent[0].type, type);
+	CHECK_EQUAL(sent[0].length, length);
+	CHECK(memcmp(sent[0].payload, payload, length) == 0);
+	clear_sent();
+}
+
+// Connect as player 1 (inviting) at time 0
+static void connect_as_player_1(void) {
+	link_init();
+	link_invite(4, 100, 0);
+	uint8_t version = LINK_VERSION;
+	receive(LINK_ACCEPT, &version, 1, 0);
+	clear_sent();
+}
+
+static void test_join(void) {
+	link_init();
+	CHECK_EQUAL(link_state(), LINK_OFF);
+	clear_sent();
+
+	// Invitations for another version are ignored
+	uint8_t wrong_version[3] = {LINK_VERSION + 1, 50, 3};
+	receive(LINK_INVITE, wrong_version, 3, 0);
+	CHECK_EQUAL(link_state(), LINK_OFF);
+	CHECK_EQUAL(sent_count, 0);
+
+	receive_invite(50, 3, 0);
+	CHECK_EQUAL(link_state(), LINK_CONNECTED);
+	CHECK(!link_is_player_1());
+	CHECK_EQUAL(link_board_number(), 3);
+	uint8_t version = LINK_VERSION;
+	check_sent(LINK_ACCEPT, &version, 1);
+
+	// Once connected, more invitations are ignored
+	receive_invite(60, 7, 10);
+	CHECK_EQUAL(link_board_number(), 3);
+	CHECK_EQUAL(sent_count, 0);
+}
+
+static void test_invite(void) {
+	link_init();
+	clear_sent();
+	link_invite(5, 100, 1000);
+	CHECK_EQUAL(link_state(), LINK_INVITING);
+	uint8_t invite[3] = {LINK_VERSION, 100, 5};
+	check_sent(LINK_INVITE, invite, 3);
+
+	// Invitations are repeated until accepted
+	link_poll(1000 + LINK_INVITE_MS - 1);
+	CHECK_EQUAL(sent_count, 0);
+	link_poll(1000 + LINK_INVITE_MS);
+	check_sent(LINK_INVITE, invite, 3);
+
+	uint8_t version = LINK_VERSION;
+	receive(LINK_ACCEPT, &version, 1, 1300);
+	CHECK_EQUAL(link_state(), LINK_CONNECTED);
+	CHECK(link_is_player_1());
+	CHECK_EQUAL(link_board_number(), 5);
+	CHECK_EQUAL(sent_count, 0);
+}
+
+static void test_both_invite(void) {
+	// The other unit's nonce is smaller - it should accept ours
+	link_init();
+	link_invite(5, 100, 0);
+	clear_sent();
+	receive_invite(99, 2, 0);
+	CHECK_EQUAL(link_state(), LINK_INVITING);
+	CHECK_EQUAL(sent_count, 0);
+
+	// The other unit's nonce is larger - accept its invitation and board
+	receive_invite(101, 2, 0);
+	CHECK_EQUAL(link_state(), LINK_CONNECTED);
+	CHECK(!link_is_player_1());
+	CHECK_EQUAL(link_board_number(), 2);
+	uint8_t version = LINK_VERSION;
+	check_sent(LINK_ACCEPT, &version, 1);
+
+	// Equal nonces - invite again at once with a different nonce, and
+	// keep doing so until the nonces differ
+	for (uint8_t nonce = 0; nonce < 255; nonce += 15) {
+		link_init();
+		link_invite(5, nonce, 0);
+		clear_sent();
+		uint8_t other_nonce = nonce;
+		for (int attempt = 0; attempt < 3; attempt++) {
+			receive_invite(other_nonce, 2, attempt * 7);
+			CHECK_EQUAL(link_state(), LINK_INVITING);
+			CHECK_EQUAL(sent_count, 1);
+			CHECK_EQUAL(sent[0].type, LINK_INVITE);
+			CHECK(sent[0].payload[1] != other_nonce);
+			other_nonce = sent[0].payload[1];
+			clear_sent();
+		}
+	}
+}
+
+static void test_turns(void) {
+	connect_as_player_1();
+
+	link_send_turn(LINK_ACTION_ROLL, 4, 0x1234);
+	uint8_t first[5] = {0, LINK_ACTION_ROLL, 4, 0x34, 0x12};
+	check_sent(LINK_TURN, first, 5);
+	link_send_turn(LINK_ACTION_STEP, 1, 0xBEEF);
+	uint8_t second[5] = {1, LINK_ACTION_STEP, 1, 0xEF, 0xBE};
+	check_sent(LINK_TURN, second, 5);
+
+	LinkTurn turn;
+	CHECK(!link_get_turn(&turn));
+	receive_turn(0, LINK_ACTION_STEP, 2, 0x0102, 10);
+	receive_turn(1, LINK_ACTION_TURN, 3, 0xA0B0, 20);
+	CHECK(link_get_turn(&turn));
+	CHECK_EQUAL(turn.action, LINK_ACTION_STEP);
+	CHECK_EQUAL(turn.value, 2);
+	CHECK_EQUAL(turn.hash, 0x0102);
+	link_check_hash(turn.hash, 0x0102);
+	CHECK(link_get_turn(&turn));
+	CHECK_EQUAL(turn.action, LINK_ACTION_TURN);
+	CHECK_EQUAL(turn.value, 3);
+	CHECK_EQUAL(turn.hash, 0xA0B0);
+	CHECK(!link_get_turn(&turn));
+	CHECK_EQUAL(link_state(), LINK_CONNECTED);
+	CHECK_EQUAL(sent_count, 0);
+
+	// A move goes missing
+	receive_turn(3, LINK_ACTION_TURN, 1, 0, 30);
+	CHECK_EQUAL(link_state(), LINK_DESYNCED);
+	check_sent(LINK_DESYNC, 0, 0);
+	CHECK(!link_get_turn(&turn));
+
+	// Nothing more is sent once out of sync
+	link_send_turn(LINK_ACTION_ROLL, 1, 0);
+	CHECK_EQUAL(sent_count, 0);
+
+	// A new connection starts the sequence numbers again
+	connect_as_player_1();
+	link_send_turn(LINK_ACTION_ROLL, 4, 0x1234);
+	check_sent(LINK_TURN, first, 5);
+	receive_turn(0, LINK_ACTION_TURN, 3, 0, 10);
+	CHECK(link_get_turn(&turn));
+	CHECK_EQUAL(link_state(), LINK_CONNECTED);
+}
+
+static void test_desync(void) {
+	// The hash after the other unit's move doesn't match
+	connect_as_player_1();
+	link_check_hash(0x1234, 0x1235);
+	CHECK_EQUAL(link_state(), LINK_DESYNCED);
+	check_sent(LINK_DESYNC, 0, 0);
+
+	// The other unit says the units are out of sync
+	connect_as_player_1();
+	receive(LINK_DESYNC, 0, 0, 10);
+	CHECK_EQUAL(link_state(), LINK_DESYNCED);
+	CHECK_EQUAL(sent_count, 0);
+
+	// Same boards, whichever unit says first
+	connect_as_player_1();
+	uint8_t board[2] = {0x11, 0x22};
+	receive(LINK_BOARD, board, 2, 10);
+	link_send_board(0x2211);
+	check_sent(LINK_BOARD, board, 2);
+	CHECK_EQUAL(link_state(), LINK_CONNECTED);
+	connect_as_player_1();
+	link_send_board(0x2211);
+	check_sent(LINK_BOARD, board, 2);
+	receive(LINK_BOARD, board, 2, 10);
+	CHECK_EQUAL(link_state(), LINK_CONNECTED);
+	CHECK_EQUAL(sent_count, 0);
+
+	// Different boards
+	connect_as_player_1();
+	link_send_board(0x2212);
+	clear_sent();
+	receive(LINK_BOARD, board, 2, 10);
+	CHECK_EQUAL(link_state(), LINK_DESYNCED);
+	check_sent(LINK_DESYNC, 0, 0);
+}
+
+static void test_lost_accept(void) {
+	link_init();
+	receive_invite(50, 3, 0);
+	clear_sent();
+
+	// The inviting unit didn't hear the acceptance and invites again
+	receive_invite(50, 3, LINK_INVITE_MS);
+	CHECK_EQUAL(link_state(), LINK_CONNECTED);
+	uint8_t version = LINK_VERSION;
+	check_sent(LINK_ACCEPT, &version, 1);
+
+	// Other invitations are still ignored
+	receive_invite(51, 3, 2 * LINK_INVITE_MS);
+	CHECK_EQUAL(sent_count, 0);
+	CHECK_EQUAL(link_board_number(), 3);
+
+	// As are invitations to player 1, even with the nonce it sent
+	connect_as_player_1();
+	receive_invite(100, 4, 10);
+	CHECK_EQUAL(sent_count, 0);
+	CHECK_EQUAL(link_state(), LINK_CONNECTED);
+}
+
+static void test_lost_last_turn(void) {
+	connect_as_player_1();
+	receive_turn(0, LINK_ACTION_STEP, 2, 0, 10);
+	uint8_t sequence = 1;
+	receive(LINK_PING, &sequence, 1, 300);
+	CHECK_EQUAL(link_state(), LINK_CONNECTED);
+	CHECK_EQUAL(sent_count, 0);
+
+	// The other unit's last move is lost - both units would wait for the
+	// other to move, but the next ping shows the move is missing
+	sequence = 2;
+	receive(LINK_PING, &sequence, 1, 600);
+	CHECK_EQUAL(link_state(), LINK_DESYNCED);
+	check_sent(LINK_DESYNC, 0, 0);
+}
+
+static void test_timeout(void) {
+	// Connected at time 0. Pings are sent when nothing else has been.
+	connect_as_player_1();
+	link_poll(LINK_PING_MS - 1);
+	CHECK_EQUAL(sent_count, 0);
+	link_poll(LINK_PING_MS);
+	uint8_t sequence = 0;
+	check_sent(LINK_PING, &sequence, 1);
+	link_poll(400);
+	link_send_turn(LINK_ACTION_ROLL, 2, 0);
+	clear_sent();
+	link_poll(2 * LINK_PING_MS);
+	CHECK_EQUAL(sent_count, 0);
+	link_poll(400 + LINK_PING_MS);
+	sequence = 1;
+	check_sent(LINK_PING, &sequence, 1);
+
+	// Anything from the other unit shows it is still there
+	sequence = 0;
+	receive(LINK_PING, &sequence, 1, 1000);
+	link_poll(1000 + LINK_TIMEOUT_MS - 1);
+	CHECK_EQUAL(link_state(), LINK_CONNECTED);
+	link_poll(1000 + LINK_TIMEOUT_MS);
+	CHECK_EQUAL(link_state(), LINK_LOST);
+
+	// The clock wrapping around doesn't lose the link
+	link_init();
+	uint32_t start = 0xFFFFFF00;
+	link_invite(1, 100, start);
+	uint8_t version = LINK_VERSION;
+	receive(LINK_ACCEPT, &version, 1, start);
+	link_poll(start + LINK_TIMEOUT_MS - 1);
+	CHECK_EQUAL(link_state(), LINK_CONNECTED);
+	link_poll(start + LINK_TIMEOUT_MS);
+	CHECK_EQUAL(link_state(), LINK_LOST);
+}
+
+int main(void) {
+	frame_parser_init(&sent_parser);
+	test_join();
+	test_invite();
+	test_both_invite();
+	test_turns();
+	test_desync();
+	test_lost_accept();
+	test_lost_last_turn();
+	test_timeout();
+	CHECK_EQUAL(bad_bytes, 0);
+	return test_summary("test_link");
+}
@@ -0,0 +1,207 @@
+/*
+ * test_serial.c
+ *
+ * Author: Arjun Srikanth
+ *
+ * Host tests of the circular buffers in serialio.c and uart1.c, with the
+ * tests calling the interrupt handlers (see avr_sim.h). Build and run from
+ * the top directory with
+ *
+ *     cc -Ihost -o test_serial host/test_serial.c host/avr_sim.c serialio.c uart1.c
+ *     ./test_serial
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <avr/io.h>
+#include "../serialio.h"
+#include "../uart1.h"
+#include "avr_sim.h"
+#include "test.h"
+
+// Run the data register empty handler until it turns itself off, copying
+// each byte the UART would send to sent. Returns how many were sent.
+static int drain_serial(char* sent, int max) {
+	int count = 0;
+	while (UCSR0B & (1<<UDRIE0)) {
+		UDR0 = 0;
+		uint8_t pending = serial_output_pending();
+		USART0_UDRE_vect();
+		if (pending && count < max) {
+			sent[count++] = UDR0;
+		}
+	}
+	return count;
+}
+
+static void receive_serial(char c) {
+	UDR0 = c;
+	USART0_RX_vect();
+}
+
+static void test_serial_output(void) {
+	char sent[1024];
+	char data[600];
+	for (int i = 0; i < 600; i++) {
+		data[i] = 'a' + i % 26;
+	}
+
+	CHECK_EQUAL(serial_output_space(), 255);
+	CHECK_EQUAL(serial_output_pending(), 0);
+	CHECK_EQUAL(serial_write(data, 10), 10);
+	CHECK_EQUAL(serial_output_pending(), 10);
+	CHECK_EQUAL(serial_output_space(), 245);
+	CHECK_EQUAL(serial_output_count(), 10);
+	CHECK(UCSR0B & (1<<UDRIE0));
+	CHECK_EQUAL(drain_serial(sent, sizeof(sent)), 10);
+	CHECK(memcmp(sent, data, 10) == 0);
+	CHECK_EQUAL(serial_output_pending(), 0);
+
+	// Positions wrap around the end of the buffer
+	for (int round = 0; round < 5; round++) {
+		CHECK_EQUAL(serial_write(data, 100), 100);
+		CHECK_EQUAL(drain_serial(sent, sizeof(sent)), 100);
+		CHECK(memcmp(sent, data, 100) == 0);
+	}
+	CHECK_EQUAL(serial_output_count(), 510);
+
+	// The buffer holds one less character than its size. With interrupts
+	// off nothing waits for room, so a write which doesn't fit is dropped
+	// a chunk at a time.
+	SerialOutputStats stats;
+	CHECK_EQUAL(serial_write(data, 255), 255);
+	CHECK_EQUAL(serial_output_space(), 0);
+	CHECK_EQUAL(serial_write(data, 1), 0);
+	serial_get_output_stats(&stats);
+	CHECK_EQUAL(stats.dropped_bytes, 1);
+	CHECK_EQUAL(stats.dropped_writes, 1);
+	CHECK_EQUAL(drain_serial(sent, sizeof(sent)), 255);
+	CHECK(memcmp(sent, data, 255) == 0);
+
+	CHECK_EQUAL(serial_write(data, 600), 255);
+	serial_get_output_stats(&stats);
+	CHECK_EQUAL(stats.dropped_bytes, 1 + 345);
+	CHECK_EQUAL(stats.dropped_writes, 2);
+	CHECK_EQUAL(drain_serial(sent, sizeof(sent)), 255);
+	CHECK(memcmp(sent, data, 255) == 0);
+	CHECK_EQUAL(drain_serial(sent, sizeof(sent)), 0);
+
+	// In non-blocking mode a write which doesn't fit is dropped even with
+	// interrupts on - and never cut off part way
+	serial_set_output_nonblocking(1);
+	SREG |= (1<<SREG_I);
+	CHECK_EQUAL(serial_write(data, 200), 200);
+	CHECK_EQUAL(serial_write(data + 200, 100), 0);
+	CHECK_EQUAL(serial_write(data + 200, 55), 55);
+	SREG &= ~(1<<SREG_I);
+	serial_set_output_nonblocking(0);
+	CHECK_EQUAL(drain_serial(sent, sizeof(sent)), 255);
+	CHECK(memcmp(sent, data, 255) == 0);
+}
+
+static void test_serial_input(void) {
+	char buf[SERIAL_INPUT_BUFFER_SIZE];
+	SerialInputStats stats;
+	CHECK(!serial_input_available());
+	CHECK_EQUAL(serial_read_input(buf, sizeof(buf)), 0);
+
+	// Characters are kept as they are (no \r to \n) and can be read a few
+	// at a time
+	const char* text = "ab\rcd";
+	for (int i = 0; i < 5; i++) {
+		receive_serial(text[i]);
+	}
+	CHECK(serial_input_available());
+	CHECK_EQUAL(serial_input_count(), 5);
+	CHECK_EQUAL(serial_read_input(buf, 3), 3);
+	CHECK(memcmp(buf, "ab\r", 3) == 0);
+	CHECK_EQUAL(serial_input_count(), 2);
+	CHECK_EQUAL(serial_read_input(buf, sizeof(buf)), 2);
+	CHECK(memcmp(buf, "cd", 2) == 0);
+	CHECK(!serial_input_available());
+
+	// Fill the buffer (wrapping around its end) and overrun it
+	for (int i = 0; i < SERIAL_INPUT_BUFFER_SIZE + 4; i++) {
+		receive_serial('A' + i);
+	}
+	CHECK_EQUAL(serial_input_count(), SERIAL_INPUT_BUFFER_SIZE - 1);
+	serial_get_input_stats(&stats);
+	CHECK_EQUAL(stats.overruns, 5);
+	CHECK_EQUAL(stats.high_water, SERIAL_INPUT_BUFFER_SIZE - 1);
+	CHECK_EQUAL(serial_read_input(buf, sizeof(buf)), SERIAL_INPUT_BUFFER_SIZE - 1);
+	bool in_order = true;
+	for (int i = 0; i < SERIAL_INPUT_BUFFER_SIZE - 1; i++) {
+		in_order = in_order && buf[i] == 'A' + i;
+	}
+	CHECK(in_order);
+
+	serial_clear_input_stats();
+	serial_get_input_stats(&stats);
+	CHECK_EQUAL(stats.overruns, 0);
+	CHECK_EQUAL(stats.high_water, 0);
+
+	receive_serial('x');
+	receive_serial('y');
+	clear_serial_input_buffer();
+	CHECK(!serial_input_available());
+	serial_get_input_stats(&stats);
+	CHECK_EQUAL(stats.high_water, 2);
+}
+
+static void test_uart1(void) {
+	init_uart1(38400);
+	CHECK_EQUAL(UBRR1, 12);
+
+	// Transmit - the buffer holds one less byte than its size, so fill it
+	// and empty it twice to wrap around
+	uint8_t data[UART1_BUFFER_SIZE];
+	for (int i = 0; i < UART1_BUFFER_SIZE; i++) {
+		data[i] = i * 3;
+	}
+	for (int round = 0; round < 2; round++) {
+		uart1_write(data, UART1_BUFFER_SIZE - 1);
+		CHECK(UCSR1B & (1<<UDRIE1));
+		bool in_order = true;
+		int sent = 0;
+		while (UCSR1B & (1<<UDRIE1)) {
+			USART1_UDRE_vect();
+			if (UCSR1B & (1<<UDRIE1)) {
+				in_order = in_order && UDR1 == data[sent];
+				sent++;
+			}
+		}
+		CHECK_EQUAL(sent, UART1_BUFFER_SIZE - 1);
+		CHECK(in_order);
+	}
+
+	// Receive - bytes which don't fit are lost
+	CHECK(!uart1_available());
+	for (int i = 0; i < UART1_BUFFER_SIZE + 10; i++) {
+		UDR1 = i;
+		USART1_RX_vect();
+	}
+	CHECK(uart1_available());
+	uint8_t buf[UART1_BUFFER_SIZE];
+	CHECK_EQUAL(uart1_read(buf, 10), 10);
+	CHECK_EQUAL(buf[0], 0);
+	CHECK_EQUAL(buf[9], 9);
+	CHECK_EQUAL(uart1_read(buf, sizeof(buf)), UART1_BUFFER_SIZE - 11);
+	CHECK_EQUAL(buf[UART1_BUFFER_SIZE - 12], UART1_BUFFER_SIZE - 2);
+	CHECK(!uart1_available());
+
+	UDR1 = 0x55;
+	USART1_RX_vect();
+	uart1_clear_input();
+	CHECK(!uart1_available());
+	CHECK_EQUAL(uart1_read(buf, sizeof(buf)), 0);
+}
+
+int main(void) {
+	avr_sim_init();
+	test_serial_output();
+	test_serial_input();
+	test_uart1();
+	return test_summary("test_serial");
+}
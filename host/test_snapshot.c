@@ -0,0 +1,249 @@
+/*
+ * test_snapshot.c
+ *
+ * Author: Arjun Srikanth
+ *
+ * Host tests of the game snapshots in EEPROM (see snapshot.h). Each time
+ * the unit is turned on is a child process, so it starts with nothing but
+ * what is in the (simulated) EEPROM - and a child which stops part way
+ * through a write stands in for a power cut. Build and run from the top
+ * directory with the line below (storage.c turns 16 bit EEPROM addresses
+ * into pointers for avr-libc, which the compiler warns about on a PC)
+ *
+ *     cc -Ihost -Wno-int-to-pointer-cast -o test_snapshot host/test_snapshot.c \
+ *             host/avr_sim.c snapshot.c storage.c frame.c
+ *     ./test_snapshot
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <avr/io.h>
+#include "../boards.h"
+#include "../frame.h"
+#include "../snapshot.h"
+#include "../storage.h"
+#include "avr_sim.h"
+#include "test.h"
+
+// Slots as laid out by snapshot.c - sequence number, snapshot, CRC-8
+#define SLOT_SIZE (SNAPSHOT_SIZE + 2)
+#define SLOT_ADDRESS(slot) (BOARDS_EEPROM_SIZE + (slot) * SLOT_SIZE)
+
+// Most EEPROM ready interrupts a snapshot write can take (one per byte,
+// and one to turn the interrupt off)
+#define MAX_WRITE_STEPS (2 * SLOT_SIZE + 1)
+
+// Snapshot number n of a game
+static void make_snapshot(uint8_t* snapshot, int n) {
+	snapshot[0] = n & 0xFF;
+	snapshot[1] = n >> 8;
+	for (int i = 2; i < SNAPSHOT_SIZE; i++) {
+		snapshot[i] = n * 7 + i * 31;
+	}
+}
+
+// Turn the unit on and load the newest snapshot. Returns its number, or
+// -1 if there isn't one (or it isn't any made by make_snapshot()).
+static int power_on(void) {
+	uint8_t snapshot[SNAPSHOT_SIZE];
+	if (!snapshot_load(snapshot)) {
+		return -1;
+	}
+	for (int n = 0; n < 1000; n++) {
+		uint8_t expected[SNAPSHOT_SIZE];
+		make_snapshot(expected, n);
+		if (memcmp(snapshot, expected, SNAPSHOT_SIZE) == 0) {
+			return n;
+		}
+	}
+	return -2;
+}
+
+// Call the EEPROM ready interrupt handler until it turns itself off, at
+// most steps times. Returns how many times it was called.
+static int run_writer(int steps) {
+	int count = 0;
+	while ((EECR & (1<<EERIE)) && count < steps) {
+		EE_READY_vect();
+		count++;
+	}
+	return count;
+}
+
+static void save(int n) {
+	uint8_t snapshot[SNAPSHOT_SIZE];
+	make_snapshot(snapshot, n);
+	snapshot_save(snapshot);
+}
+
+// Slot holding a good copy of snapshot n, or -1 if none does
+static int find_slot(int n) {
+	uint8_t expected[SNAPSHOT_SIZE];
+	make_snapshot(expected, n);
+	for (int slot = 0; slot < SNAPSHOT_SLOTS; slot++) {
+		const uint8_t* data = avr_sim_eeprom + SLOT_ADDRESS(slot);
+		uint8_t crc = 0;
+		for (int i = 0; i < SLOT_SIZE - 1; i++) {
+			crc = frame_crc_update(crc, data[i]);
+		}
+		if (crc == data[SLOT_SIZE - 1]
+				&& memcmp(data + 1, expected, SNAPSHOT_SIZE) == 0) {
+			return slot;
+		}
+	}
+	return -1;
+}
+
+// Run a power on in a child process, which sends back its counts of
+// checks made and failed
+static void run_unit(void (*unit)(void)) {
+	int counts_pipe[2];
+	if (pipe(counts_pipe) != 0) {
+		perror("pipe");
+		exit(1);
+	}
+	fflush(stdout);
+	pid_t pid = fork();
+	if (pid == 0) {
+		test_checks = 0;
+		test_failures = 0;
+		unit();
+		unsigned counts[2] = {test_checks, test_failures};
+		exit(write(counts_pipe[1], counts, sizeof(counts)) != sizeof(counts));
+	}
+	close(counts_pipe[1]);
+	unsigned counts[2];
+	if (read(counts_pipe[0], counts, sizeof(counts)) == sizeof(counts)) {
+		test_checks += counts[0];
+		test_failures += counts[1];
+	} else {
+		fprintf(stderr, "unit process didn't finish\n");
+		test_failures++;
+	}
+	close(counts_pipe[0]);
+	waitpid(pid, 0, 0);
+}
+
+// Snapshot expected at the next power on, and how far the next torn
+// write gets
+static int expected_newest;
+static int torn_steps;
+
+static void unit_check_newest(void) {
+	CHECK_EQUAL(power_on(), expected_newest);
+}
+
+// Save enough snapshots to go round the slots several times and wrap the
+// sequence number around
+static void unit_save_many(void) {
+	CHECK_EQUAL(power_on(), -1);
+	for (int n = 1; n <= 300; n++) {
+		save(n);
+		CHECK(run_writer(MAX_WRITE_STEPS) <= SLOT_SIZE + 1);
+		CHECK(!(EECR & (1<<EERIE)));
+		if (n % 37 == 0) {
+			CHECK_EQUAL(power_on(), n);
+		}
+	}
+}
+
+static void unit_torn_write(void) {
+	CHECK_EQUAL(power_on(), 300);
+	save(301);
+	CHECK_EQUAL(run_writer(torn_steps), torn_steps);
+}
+
+static void unit_finish_write(void) {
+	CHECK_EQUAL(power_on(), 300);
+	save(301);
+	run_writer(MAX_WRITE_STEPS);
+}
+
+// Snapshots saved while one is being written - only the last is kept
+static void unit_save_while_writing(void) {
+	CHECK_EQUAL(power_on(), 301);
+	save(302);
+	run_writer(3);
+	save(303);
+	run_writer(2);
+	save(304);
+	CHECK_EQUAL(find_slot(302), -1);
+	run_writer(SLOT_SIZE - 5);
+	CHECK(find_slot(302) >= 0);
+	CHECK(EECR & (1<<EERIE));
+
+	// 302 has been written and 304 is still waiting - one saved now
+	// replaces it rather than being written before it
+	save(305);
+	run_writer(MAX_WRITE_STEPS);
+	CHECK(!(EECR & (1<<EERIE)));
+	CHECK_EQUAL(find_slot(303), -1);
+	CHECK_EQUAL(find_slot(304), -1);
+	CHECK_EQUAL(find_slot(305), (find_slot(302) + 1) % SNAPSHOT_SLOTS);
+	CHECK_EQUAL(power_on(), 305);
+}
+
+// Other EEPROM access part way through a write holds the writer off and
+// lets it carry on afterwards
+static void unit_storage_during_write(void) {
+	CHECK_EQUAL(power_on(), 305);
+	save(306);
+	run_writer(5);
+	CHECK_EQUAL(storage_read_byte(0), 0xFF);
+	CHECK(EECR & (1<<EERIE));
+	storage_update_word(2, 0x1234);
+	CHECK(EECR & (1<<EERIE));
+	CHECK_EQUAL(storage_read_word(2), 0x1234);
+	run_writer(MAX_WRITE_STEPS);
+	CHECK(!(EECR & (1<<EERIE)));
+	CHECK_EQUAL(power_on(), 306);
+}
+
+int main(void) {
+	avr_sim_init();
+	CHECK(SLOT_ADDRESS(SNAPSHOT_SLOTS) <= E2END + 1);
+
+	expected_newest = -1;
+	run_unit(unit_check_newest);
+
+	run_unit(unit_save_many);
+	expected_newest = 300;
+	run_unit(unit_check_newest);
+
+	// Power cuts part way through writing the next snapshot leave the one
+	// before it as the newest
+	for (torn_steps = 0; torn_steps < SLOT_SIZE; torn_steps++) {
+		run_unit(unit_torn_write);
+		expected_newest = 300;
+		run_unit(unit_check_newest);
+	}
+	run_unit(unit_finish_write);
+	expected_newest = 301;
+	run_unit(unit_check_newest);
+
+	// A damaged newest slot is skipped
+	int slot = find_slot(301);
+	CHECK(slot >= 0);
+	avr_sim_eeprom[SLOT_ADDRESS(slot) + 5] ^= 0x10;
+	expected_newest = 300;
+	run_unit(unit_check_newest);
+	avr_sim_eeprom[SLOT_ADDRESS(slot) + 5] ^= 0x10;
+
+	run_unit(unit_save_while_writing);
+	expected_newest = 305;
+	run_unit(unit_check_newest);
+
+	run_unit(unit_storage_during_write);
+
+	// A blank EEPROM again
+	avr_sim_init();
+	expected_newest = -1;
+	run_unit(unit_check_newest);
+
+	return test_summary("test_snapshot");
+}
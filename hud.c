@@ -0,0 +1,164 @@
+/*
+ * hud.c
+ *
+ * Author: Arjun Srikanth
+ */
+
+#include "hud.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <avr/pgmspace.h>
+#include "terminalio.h"
+#include "serialio.h"
+#include "format.h"
+#include "memory.h"
+
+// Where each field is on the terminal and how wide it is. The fields all
+// finish before the board mirror (see terminal_board.h).
+typedef struct {
+	uint8_t x;
+	uint8_t y;
+	uint8_t width;
+	uint8_t offset;		// start of this field in shown_text
+} HudLayout;
+
+static const HudLayout layout[HUD_NUM_FIELDS] PROGMEM = {
+	[HUD_MESSAGE] = {10, 12, 44, 0},
+	[HUD_STATUS] = {10, 14, 24, 44},
+	[HUD_TIMER] = {10, 16, 20, 68},
+	[HUD_DICE] = {10, 18, 8, 88},
+	[HUD_MOVES] = {20, 18, 12, 96}
+};
+#define HUD_TEXT_SIZE 108
+
+// The text currently shown in every field
+static char shown_text[HUD_TEXT_SIZE];
+
+static bool hud_enabled;
+
+// Where the terminal cursor was left by the last run written here. It is
+// only still there if nothing else has been written since, i.e. while
+// serial_output_count() is still cursor_count.
+static bool cursor_known;
+static uint8_t cursor_x;
+static uint8_t cursor_y;
+static uint16_t cursor_count;
+
+void hud_init(void) {
+	memory_register(PSTR("terminal text fields"), sizeof(shown_text));
+	hud_enabled = true;
+	cursor_known = false;
+	for (uint8_t i = 0; i < HUD_TEXT_SIZE; i++) {
+		shown_text[i] = ' ';
+	}
+}
+
+void hud_disable(void) {
+	hud_enabled = false;
+}
+
+// Append the escape sequence to move the cursor to (x, y), or nothing if
+// it is already there. Moving forward along the same row only needs a
+// cursor forward sequence.
+static uint8_t format_move_to(char* buf, uint8_t x, uint8_t y) {
+	if (cursor_known && serial_output_count() == cursor_count && y == cursor_y) {
+		if (x == cursor_x) {
+			return 0;
+		}
+		if (x > cursor_x) {
+			return terminal_format_cursor_forward(buf, 0, x - cursor_x);
+		}
+	}
+	return terminal_format_cursor_move(buf, 0, x, y);
+}
+
+// Write the changed characters of text (which must be padded to the width
+// of the field). Each run of changed characters is sent as one
+// serial_write(), with a single cursor move if the cursor isn't already
+// there. Short gaps of unchanged characters are included in a run as that
+// is shorter than moving the cursor past them. If a run can't be sent
+// (serial output is being discarded) the shown text isn't changed, so the
+// run is tried again next time.
+static void update_field(HudField field, const char* text) {
+	if (!hud_enabled) {
+		return;
+	}
+	HudLayout field_layout;
+	memcpy_P(&field_layout, &layout[field], sizeof(HudLayout));
+	char* shown = &shown_text[field_layout.offset];
+
+	char buf[TERMINAL_MAX_SEQUENCE + HUD_MAX_WIDTH];
+	uint8_t i = 0;
+	while (i < field_layout.width) {
+		if (text[i] == shown[i]) {
+			i++;
+			continue;
+		}
+		// Start of a run - find where it ends
+		uint8_t run_start = i;
+		uint8_t run_end = i + 1;
+		for (uint8_t j = run_end; j < field_layout.width && j <= run_end + 3; j++) {
+			if (text[j] != shown[j]) {
+				run_end = j + 1;
+			}
+		}
+
+		uint8_t len = format_move_to(buf, field_layout.x + run_start, field_layout.y);
+		for (uint8_t j = run_start; j < run_end; j++) {
+			buf[len++] = text[j];
+		}
+		if (serial_write(buf, len) == len) {
+			for (uint8_t j = run_start; j < run_end; j++) {
+				shown[j] = text[j];
+			}
+			cursor_known = true;
+			cursor_x = field_layout.x + run_end;
+			cursor_y = field_layout.y;
+			cursor_count = serial_output_count();
+		} else {
+			cursor_known = false;
+		}
+		i = run_end;
+	}
+}
+
+// Pad the text in buffer with spaces up to the width of the field
+static void pad_field(HudField field, char* buffer, uint8_t length) {
+	uint8_t width = pgm_read_byte(&layout[field].width);
+	while (length < width) {
+		buffer[length++] = ' ';
+	}
+}
+
+void hud_set_P(HudField field, const char* text) {
+	char buffer[HUD_MAX_WIDTH + 1];
+	uint8_t width = pgm_read_byte(&layout[field].width);
+	uint8_t length = 0;
+	char c;
+	while (length < width && (c = pgm_read_byte(text + length)) != 0) {
+		buffer[length++] = c;
+	}
+	pad_field(field, buffer, length);
+	update_field(field, buffer);
+}
+
+void hud_set(HudField field, const char* text, uint8_t length) {
+	char buffer[HUD_MAX_WIDTH + 1];
+	uint8_t width = pgm_read_byte(&layout[field].width);
+	if (length > width) {
+		length = width;
+	}
+	for (uint8_t i = 0; i < length; i++) {
+		buffer[i] = text[i];
+	}
+	pad_field(field, buffer, length);
+	update_field(field, buffer);
+}
+
+void hud_set_number_P(HudField field, const char* label, uint16_t value) {
+	char buffer[HUD_MAX_WIDTH + 1];
+	uint8_t length = format_string_P(buffer, 0, label);
+	length = format_uint(buffer, length, value, 1);
+	hud_set(field, buffer, length);
+}
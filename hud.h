@@ -0,0 +1,52 @@
+/*
+ * hud.h
+ *
+ * Author: Arjun Srikanth
+ *
+ * Fixed text fields shown on the serial terminal during a game (status
+ * messages, dice value, moves and time left). The text last written to
+ * each field is remembered, so setting a field only sends the characters
+ * which have changed. Setting a field to the text it already shows sends
+ * nothing at all, so fields can be set every time around the game loop.
+ */
+
+
+#ifndef HUD_H_
+#define HUD_H_
+
+#include <stdint.h>
+
+typedef enum {
+	HUD_MESSAGE,	// e.g. game paused
+	HUD_STATUS,		// dice rolling/stopped
+	HUD_TIMER,		// time left in timed games
+	HUD_DICE,
+	HUD_MOVES,
+	HUD_NUM_FIELDS
+} HudField;
+
+// Widest field (in characters)
+#define HUD_MAX_WIDTH 44
+
+// Forget what is in the fields - called after the terminal has been
+// cleared, so every field is blank.
+void hud_init(void);
+
+// Stop drawing the fields (until hud_init() is called again), e.g. when
+// the serial port is being used for telemetry.
+void hud_disable(void);
+
+// Set the text of a field from a string in program memory. Text longer
+// than the field is cut off; shorter text is padded with spaces.
+void hud_set_P(HudField field, const char* text);
+
+// Set the text of a field to the given number of characters of text
+// (which doesn't need to be null terminated). Text can be built with the
+// functions in format.h.
+void hud_set(HudField field, const char* text, uint8_t length);
+
+// Set the text of a field to a label (in program memory) followed by a
+// number, e.g. "Moves: 12". The label must fit in the field.
+void hud_set_number_P(HudField field, const char* label, uint16_t value);
+
+#endif /* HUD_H_ */
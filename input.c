@@ -0,0 +1,87 @@
+/*
+ * input.c
+ *
+ * Author: Arjun Srikanth
+ *
+ * Keys which have been rebound are kept in a small table in RAM which is
+ * checked before the default table, so rebinding costs a few bytes of RAM
+ * rather than a RAM copy of the whole key table.
+ */
+
+#include "input.h"
+#include <stdint.h>
+#include <avr/pgmspace.h>
+#include "buttons.h"
+
+#define NUM_KEYS 128
+
+static const uint8_t default_key_actions[NUM_KEYS] PROGMEM = {
+	['r'] = ACTION_ROLL,	['R'] = ACTION_ROLL,
+	['p'] = ACTION_PAUSE,	['P'] = ACTION_PAUSE,
+	['w'] = ACTION_UP,		['W'] = ACTION_UP,
+	['s'] = ACTION_DOWN,	['S'] = ACTION_DOWN,
+	['a'] = ACTION_LEFT,	['A'] = ACTION_LEFT,
+	['d'] = ACTION_RIGHT,	['D'] = ACTION_RIGHT
+};
+
+static const uint8_t default_button_actions[NUM_BUTTONS] PROGMEM = {
+	[BUTTON0_PUSHED] = ACTION_MOVE_1,
+	[BUTTON1_PUSHED] = ACTION_MOVE_2,
+	[BUTTON2_PUSHED] = ACTION_ROLL,
+	[BUTTON3_PUSHED] = ACTION_PAUSE
+};
+
+// Keys which have been rebound, and their actions
+static char bound_keys[INPUT_MAX_KEY_BINDINGS];
+static uint8_t bound_key_actions[INPUT_MAX_KEY_BINDINGS];
+static uint8_t num_bound_keys;
+
+static uint8_t button_actions[NUM_BUTTONS];
+
+void input_reset_bindings(void) {
+	num_bound_keys = 0;
+	for (uint8_t i = 0; i < NUM_BUTTONS; i++) {
+		button_actions[i] = pgm_read_byte(&default_button_actions[i]);
+	}
+}
+
+InputAction input_key_action(char key) {
+	for (uint8_t i = 0; i < num_bound_keys; i++) {
+		if (bound_keys[i] == key) {
+			return bound_key_actions[i];
+		}
+	}
+	if ((uint8_t) key >= NUM_KEYS) {
+		return ACTION_NONE;
+	}
+	return pgm_read_byte(&default_key_actions[(uint8_t) key]);
+}
+
+InputAction input_button_action(int8_t button) {
+	if (button < 0 || button >= NUM_BUTTONS) {
+		return ACTION_NONE;
+	}
+	return button_actions[button];
+}
+
+uint8_t input_bind_key(char key, InputAction action) {
+	uint8_t i = 0;
+	while (i < num_bound_keys && bound_keys[i] != key) {
+		i++;
+	}
+	if (i == INPUT_MAX_KEY_BINDINGS) {
+		return 0;
+	}
+	if (i == num_bound_keys) {
+		bound_keys[i] = key;
+		num_bound_keys++;
+	}
+	bound_key_actions[i] = action;
+	return 1;
+}
+
+void input_bind_button(uint8_t button, InputAction action) {
+	if (button < NUM_BUTTONS) {
+		button_actions[button] = action;
+	}
+}
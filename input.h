@@ -0,0 +1,50 @@
+/*
+ * input.h
+ *
+ * Author: Arjun Srikanth
+ *
+ * Mapping of keys and push buttons to game actions. The default bindings
+ * are tables in program memory (one entry for every ASCII key and one for
+ * every button), so finding the action for an input is a single lookup.
+ * Bindings can be changed at run time with input_bind_key() and
+ * input_bind_button() - the game loop only ever sees actions.
+ */
+
+
+#ifndef INPUT_H_
+#define INPUT_H_
+
+#include <stdint.h>
+
+typedef enum {
+	ACTION_NONE,
+	ACTION_MOVE_1,		// move one space forward
+	ACTION_MOVE_2,		// move two spaces forward
+	ACTION_ROLL,		// start or stop rolling the dice
+	ACTION_PAUSE,
+	ACTION_UP,
+	ACTION_DOWN,
+	ACTION_LEFT,
+	ACTION_RIGHT
+} InputAction;
+
+// Most keys which can be rebound at once
+#define INPUT_MAX_KEY_BINDINGS 8
+
+// Go back to the default bindings
+void input_reset_bindings(void);
+
+// Return the action for a key. Keys outside the ASCII range have none.
+InputAction input_key_action(char key);
+
+// Return the action for a button (see buttons.h). NO_BUTTON_PUSHED has
+// none.
+InputAction input_button_action(int8_t button);
+
+// Change the action for a key (ACTION_NONE unbinds it). Returns 0 if
+// INPUT_MAX_KEY_BINDINGS keys have already been rebound.
+uint8_t input_bind_key(char key, InputAction action);
+
+void input_bind_button(uint8_t button, InputAction action);
+
+#endif /* INPUT_H_ */
@@ -0,0 +1,250 @@
+/*
+ * link.c
+ *
+ * Author: Arjun Srikanth
+ */
+
+#include "link.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include "frame.h"
+
+// Moves received from the other unit and not yet made. A unit can make a
+// few single square steps before ending its turn, so a few can arrive
+// between game loops.
+#define TURN_QUEUE_SIZE 8
+
+static LinkState state = LINK_OFF;
+static FrameParser parser;
+static bool player_1;
+static uint8_t board_number;
+
+// Nonce of the invitation sent - or, once connected as player 2, of the
+// invitation accepted
+static uint8_t invite_nonce;
+
+// Mixed with the arrival time of every byte received, to choose a new
+// nonce if both units invite with the same one
+static uint8_t entropy;
+
+// Time of the last link_poll() or link_receive() call, and of the last
+// frame sent and received
+static uint32_t now;
+static uint32_t last_send_time;
+static uint32_t last_receive_time;
+
+// Sequence numbers of the next move to send and to receive
+static uint8_t send_sequence;
+static uint8_t receive_sequence;
+
+static LinkTurn turn_queue[TURN_QUEUE_SIZE];
+static uint8_t turn_head;
+static uint8_t turn_count;
+
+// Board checksums of both units (once known)
+static bool board_known;
+static bool other_board_known;
+static uint16_t board_checksum;
+static uint16_t other_board_checksum;
+
+static void send(uint8_t type, const uint8_t* payload, uint8_t length) {
+	uint8_t frame[FRAME_MAX_SIZE];
+	uint8_t size = frame_build(frame, type, payload, length);
+	link_transport_write(frame, size);
+	last_send_time = now;
+}
+
+static void send_invite(void) {
+	uint8_t payload[3] = {LINK_VERSION, invite_nonce, board_number};
+	send(LINK_INVITE, payload, 3);
+}
+
+// The units are out of sync - tell the other unit (if it doesn't know)
+static void desync(bool tell_other) {
+	state = LINK_DESYNCED;
+	if (tell_other) {
+		send(LINK_DESYNC, 0, 0);
+	}
+}
+
+static void connect(bool is_player_1) {
+	state = LINK_CONNECTED;
+	player_1 = is_player_1;
+	send_sequence = 0;
+	receive_sequence = 0;
+	turn_head = 0;
+	turn_count = 0;
+	board_known = false;
+	other_board_known = false;
+}
+
+static void check_boards(void) {
+	if (board_known && other_board_known && board_checksum != other_board_checksum) {
+		desync(true);
+	}
+}
+
+void link_init(void) {
+	state = LINK_OFF;
+	frame_parser_init(&parser);
+}
+
+void link_invite(uint8_t board, uint8_t nonce, uint32_t current_time) {
+	now = current_time;
+	state = LINK_INVITING;
+	board_number = board;
+	invite_nonce = nonce;
+	send_invite();
+}
+
+// Handle a complete frame from the other unit
+static void handle_frame(void) {
+	const uint8_t* payload = parser.payload;
+	last_receive_time = now;
+
+	switch (parser.type) {
+		case LINK_INVITE:
+			if (parser.length != 3 || payload[0] != LINK_VERSION) {
+				break;
+			}
+			if (state == LINK_CONNECTED) {
+				if (!player_1 && payload[1] == invite_nonce) {
+					// Our acceptance was lost and the other unit is
+					// still inviting - accept again
+					uint8_t version = LINK_VERSION;
+					send(LINK_ACCEPT, &version, 1);
+				}
+				break;
+			}
+			if (state == LINK_INVITING && payload[1] == invite_nonce) {
+				// Both units chose the same nonce, so neither would
+				// accept - choose another (the other unit does too,
+				// with its own entropy) and invite again
+				invite_nonce += entropy | 1;
+				send_invite();
+				break;
+			}
+			// Accept unless also inviting and should be player 1 ourselves
+			if (state == LINK_INVITING && payload[1] < invite_nonce) {
+				break;
+			}
+			board_number = payload[2];
+			invite_nonce = payload[1];
+			connect(false);
+			uint8_t version = LINK_VERSION;
+			send(LINK_ACCEPT, &version, 1);
+			break;
+		case LINK_ACCEPT:
+			if (state == LINK_INVITING && parser.length == 1
+					&& payload[0] == LINK_VERSION) {
+				connect(true);
+			}
+			break;
+		case LINK_BOARD:
+			if (state == LINK_CONNECTED && parser.length == 2) {
+				other_board_checksum = payload[0] | (payload[1] << 8);
+				other_board_known = true;
+				check_boards();
+			}
+			break;
+		case LINK_TURN:
+			if (state != LINK_CONNECTED || parser.length != 5) {
+				break;
+			}
+			if (payload[0] != receive_sequence || turn_count == TURN_QUEUE_SIZE) {
+				// A move has been lost (or can't be kept)
+				desync(true);
+				break;
+			}
+			receive_sequence++;
+			LinkTurn* turn = &turn_queue[(turn_head + turn_count) % TURN_QUEUE_SIZE];
+			turn->action = payload[1];
+			turn->value = payload[2];
+			turn->hash = payload[3] | (payload[4] << 8);
+			turn_count++;
+			break;
+		case LINK_DESYNC:
+			if (state == LINK_CONNECTED) {
+				desync(false);
+			}
+			break;
+		case LINK_PING:
+			// Every move sent before the ping should have arrived. If
+			// the last move of a turn is lost no more would come (each
+			// unit waits for the other), so this is how it's noticed.
+			if (state == LINK_CONNECTED && parser.length == 1
+					&& payload[0] != receive_sequence) {
+				desync(true);
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+void link_receive(uint8_t byte, uint32_t current_time) {
+	now = current_time;
+	entropy = ((entropy << 1) | (entropy >> 7)) ^ (uint8_t) current_time;
+	if (frame_parser_feed(&parser, byte)) {
+		handle_frame();
+	}
+}
+
+void link_poll(uint32_t current_time) {
+	now = current_time;
+	if (state == LINK_INVITING) {
+		if (now - last_send_time >= LINK_INVITE_MS) {
+			send_invite();
+		}
+	} else if (state == LINK_CONNECTED) {
+		if (now - last_receive_time >= LINK_TIMEOUT_MS) {
+			state = LINK_LOST;
+		} else if (now - last_send_time >= LINK_PING_MS) {
+			send(LINK_PING, &send_sequence, 1);
+		}
+	}
+}
+
+LinkState link_state(void) {
+	return state;
+}
+
+bool link_is_player_1(void) {
+	return player_1;
+}
+
+uint8_t link_board_number(void) {
+	return board_number;
+}
+
+void link_send_board(uint16_t checksum) {
+	board_checksum = checksum;
+	board_known = true;
+	uint8_t payload[2] = {checksum & 0xFF, checksum >> 8};
+	send(LINK_BOARD, payload, 2);
+	check_boards();
+}
+
+void link_send_turn(uint8_t action, uint8_t value, uint16_t hash) {
+	if (state != LINK_CONNECTED) {
+		return;
+	}
+	uint8_t payload[5] = {send_sequence++, action, value, hash & 0xFF, hash >> 8};
+	send(LINK_TURN, payload, 5);
+}
+
+bool link_get_turn(LinkTurn* turn) {
+	if (turn_count == 0) {
+		return false;
+	}
+	*turn = turn_queue[turn_head];
+	turn_head = (turn_head + 1) % TURN_QUEUE_SIZE;
+	turn_count--;
+	return true;
+}
+
+void link_check_hash(uint16_t expected, uint16_t actual) {
+	if (state == LINK_CONNECTED && expected != actual) {
+		desync(true);
+	}
+}
@@ -0,0 +1,109 @@
+/*
+ * link.h
+ *
+ * Author: Arjun Srikanth
+ *
+ * Two player games between two units joined by a serial cable. Each unit
+ * controls one player and the units play in lockstep: the unit whose
+ * player moves sends the move (as a LINK_TURN frame, see frame.h) along
+ * with a hash of its game state after the move. The other unit makes the
+ * same move and checks its own hash matches - if it doesn't, or a move
+ * goes missing, the units are out of sync and the game is stopped. Pings
+ * carry the number of moves sent, so a lost move is noticed even if it
+ * was the last one before the other unit waits for a reply.
+ *
+ * To link, one unit sends invitations from its start screen and the other
+ * accepts the first one it receives (and accepts it again if it is
+ * repeated, in case the acceptance was lost). The inviting unit is player
+ * 1 and chooses the board. A unit which hears nothing from the other for
+ * LINK_TIMEOUT_MS decides the link is lost.
+ *
+ * Nothing here touches the hardware - bytes received are passed to
+ * link_receive() and bytes are sent with link_transport_write(), which
+ * the program using the link must provide. This lets the protocol be run
+ * on a PC as well (see host/).
+ */
+
+
+#ifndef LINK_H_
+#define LINK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define LINK_VERSION 1
+
+// Frame types
+#define LINK_INVITE 0x30	// payload: version, nonce, board number
+#define LINK_ACCEPT 0x31	// payload: version
+#define LINK_BOARD 0x32		// payload: board checksum (least significant byte first)
+#define LINK_TURN 0x33		// payload: sequence number, action, value, state hash
+#define LINK_PING 0x34		// payload: sequence number of the next move to send
+#define LINK_DESYNC 0x35
+
+// Moves sent in LINK_TURN frames
+#define LINK_ACTION_TURN 0	// move value spaces forward and end the turn
+#define LINK_ACTION_STEP 1	// move one square (value is an InputAction direction)
+#define LINK_ACTION_ROLL 2	// dice rolled value - move that far and end the turn
+
+// Baud rate of the cable between the units
+#define LINK_BAUD 38400L
+
+#define LINK_INVITE_MS 250
+#define LINK_PING_MS 250
+#define LINK_TIMEOUT_MS 2000
+
+typedef enum {
+	LINK_OFF,
+	LINK_INVITING,
+	LINK_CONNECTED,
+	LINK_DESYNCED,
+	LINK_LOST
+} LinkState;
+
+typedef struct {
+	uint8_t action;
+	uint8_t value;
+	uint16_t hash;	// state hash of the other unit after the move
+} LinkTurn;
+
+// Provided by the program using the link - send bytes to the other unit
+void link_transport_write(const uint8_t* data, uint8_t length);
+
+// Stop using the link (LINK_OFF). An invitation can still be accepted.
+void link_init(void);
+
+// Start sending invitations. nonce should be random - if both units invite
+// at once, the one with the larger nonce becomes player 1, and if the
+// nonces are the same both units choose new ones.
+void link_invite(uint8_t board_number, uint8_t nonce, uint32_t current_time);
+
+// Handle a byte received from the other unit
+void link_receive(uint8_t byte, uint32_t current_time);
+
+// Send invitations and pings when they are due and check the other unit
+// is still there. Call regularly.
+void link_poll(uint32_t current_time);
+
+LinkState link_state(void);
+
+// Once connected - whether this unit is player 1, and the board chosen
+bool link_is_player_1(void);
+uint8_t link_board_number(void);
+
+// Tell the other unit the checksum of the board this unit is playing on.
+// The units are out of sync if the boards differ.
+void link_send_board(uint16_t checksum);
+
+// Send a move made on this unit with the state hash after the move
+void link_send_turn(uint8_t action, uint8_t value, uint16_t hash);
+
+// Get the next move made on the other unit. Returns false if there isn't
+// one waiting.
+bool link_get_turn(LinkTurn* turn);
+
+// Check the state hash after making a move from the other unit against the
+// hash the other unit sent
+void link_check_hash(uint16_t expected, uint16_t actual);
+
+#endif /* LINK_H_ */
@@ -0,0 +1,92 @@
+/*
+ * memory.c
+ *
+ * Author: Arjun Srikanth
+ *
+ * The RAM is painted by paint_stack(), which is placed in the .init3
+ * section so it runs after the stack pointer is set up but before main()
+ * (or anything else) has used any of the stack. It is naked (has no
+ * function entry or exit code) because the .init sections are run one
+ * after the other rather than called.
+ */
+
+#include "memory.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include "terminalio.h"
+
+#define PAINT 0xC5
+
+// Set by the linker - the end of the static data, where the free RAM
+// (and the heap, if it were used) starts
+extern uint8_t __heap_start;
+
+typedef struct {
+	const char* name;	// in program memory
+	uint16_t size;
+} MemoryRegion;
+
+static MemoryRegion regions[MEMORY_MAX_REGIONS];
+static uint8_t num_regions;
+
+void paint_stack(void) __attribute__((naked, used, section(".init3")));
+void paint_stack(void) {
+	uint8_t* p = &__heap_start;
+	while (p <= (uint8_t*) RAMEND) {
+		*p++ = PAINT;
+	}
+}
+
+void memory_register(const char* name, uint16_t size) {
+	uint8_t i = 0;
+	while (i < num_regions && regions[i].name != name) {
+		i++;
+	}
+	if (i == MEMORY_MAX_REGIONS) {
+		return;
+	}
+	if (i == num_regions) {
+		regions[i].name = name;
+		num_regions++;
+	}
+	regions[i].size = size;
+}
+
+uint16_t memory_static_size(void) {
+	return &__heap_start - (uint8_t*) RAMSTART;
+}
+
+uint16_t memory_min_free(void) {
+	uint8_t* p = &__heap_start;
+	while (p <= (uint8_t*) RAMEND && *p == PAINT) {
+		p++;
+	}
+	return p - &__heap_start;
+}
+
+uint16_t memory_stack_high_water(void) {
+	return ((uint8_t*) RAMEND + 1 - &__heap_start) - memory_min_free();
+}
+
+uint16_t memory_free_now(void) {
+	return (uint8_t*) SP - &__heap_start;
+}
+
+void memory_print_report(uint8_t x, uint8_t y) {
+	move_terminal_cursor(x, y++);
+	printf_P(PSTR("SRAM: %u bytes"), RAMEND + 1 - RAMSTART);
+	move_terminal_cursor(x, y++);
+	printf_P(PSTR("Static data: %u bytes"), memory_static_size());
+	move_terminal_cursor(x, y++);
+	printf_P(PSTR("Deepest stack: %u bytes"), memory_stack_high_water());
+	move_terminal_cursor(x, y++);
+	printf_P(PSTR("Free: %u bytes now, %u at the least"), memory_free_now(),
+			memory_min_free());
+	y++;
+	for (uint8_t i = 0; i < num_regions; i++) {
+		move_terminal_cursor(x, y++);
+		printf_P(PSTR("%5u  %S"), regions[i].size, regions[i].name);
+	}
+}
@@ -0,0 +1,46 @@
+/*
+ * memory.h
+ *
+ * Author: Arjun Srikanth
+ *
+ * Keeps track of how much of the 2KB of SRAM is used. At start up all the
+ * RAM between the static data and the stack is filled with a known value,
+ * so the deepest the stack has ever reached can be found later by looking
+ * for where that value has been overwritten. (Nothing uses malloc(), so
+ * nothing else uses that RAM.)
+ *
+ * Modules can also register how much static RAM they use, so the report
+ * shows where the static RAM goes.
+ */
+
+
+#ifndef MEMORY_H_
+#define MEMORY_H_
+
+#include <stdint.h>
+
+// Most modules which can register their static RAM
+#define MEMORY_MAX_REGIONS 8
+
+// Record that a module uses size bytes of static RAM. name is in program
+// memory (e.g. PSTR("serial buffers")) and registering the same name again
+// replaces the size, so this can be called from functions called more
+// than once.
+void memory_register(const char* name, uint16_t size);
+
+// Bytes of static data (initialised and zeroed variables)
+uint16_t memory_static_size(void);
+
+// Most bytes the stack has ever used
+uint16_t memory_stack_high_water(void);
+
+// Smallest gap there has ever been between the static data and the stack,
+// and the gap now
+uint16_t memory_min_free(void);
+uint16_t memory_free_now(void);
+
+// Print the report on the terminal, one line per row starting at column x
+// of row y
+void memory_print_report(uint8_t x, uint8_t y);
+
+#endif /* MEMORY_H_ */
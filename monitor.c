@@ -0,0 +1,142 @@
+/*
+ * monitor.c
+ *
+ * Author: Arjun Srikanth
+ *
+ * After a watchdog reset the watchdog is still running (with its shortest
+ * timeout), so the reset flags are saved and the watchdog is turned off
+ * before main() is called, in the .init3 section run by the C start up
+ * code.
+ */
+
+#include "monitor.h"
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <avr/wdt.h>
+#include "timer0.h"
+#include "storage.h"
+
+// Reset counts are kept at the very end of EEPROM, out of the way of the
+// board slots (see boards.c) at the start
+#define RESET_COUNTS_ADDRESS (E2END + 1 - 2 * NUM_RESET_REASONS)
+
+static const char input_name[] PROGMEM = "input";
+static const char logic_name[] PROGMEM = "logic";
+static const char render_name[] PROGMEM = "render";
+static const char serial_name[] PROGMEM = "serial";
+static const char* const phase_names[NUM_PHASES] PROGMEM = {
+	[PHASE_INPUT] = input_name,
+	[PHASE_LOGIC] = logic_name,
+	[PHASE_RENDER] = render_name,
+	[PHASE_SERIAL] = serial_name
+};
+
+// MCUSR at reset - not cleared by the start up code
+static uint8_t reset_flags __attribute__((section(".noinit")));
+static ResetReason last_reset;
+
+static uint16_t budget_us = MONITOR_DEFAULT_BUDGET_US;
+static LoopStats stats;
+
+// Current pass - when it and the current phase started, and how long each
+// phase has taken so far
+static uint32_t pass_start;
+static uint32_t phase_start;
+static LoopPhase current_phase;
+static uint32_t phase_us[NUM_PHASES];
+
+void save_reset_flags(void) __attribute__((naked, used, section(".init3")));
+void save_reset_flags(void) {
+	reset_flags = MCUSR;
+	MCUSR = 0;
+	wdt_disable();
+}
+
+void monitor_init(void) {
+	// More than one flag can be set - the watchdog is the most
+	// interesting, a power on reset the least
+	if (reset_flags & (1<<WDRF)) {
+		last_reset = RESET_WATCHDOG;
+	} else if (reset_flags & (1<<BORF)) {
+		last_reset = RESET_BROWN_OUT;
+	} else if (reset_flags & (1<<EXTRF)) {
+		last_reset = RESET_PIN;
+	} else {
+		last_reset = RESET_POWER_ON;
+	}
+	uint16_t address = RESET_COUNTS_ADDRESS + 2 * last_reset;
+	uint16_t count = storage_read_word(address);
+	// Erased EEPROM reads as 0xFFFF
+	storage_update_word(address, (count == 0xFFFF) ? 1 : count + 1);
+
+	wdt_enable(WDTO_1S);
+}
+
+void monitor_set_budget(uint16_t budget) {
+	budget_us = budget;
+}
+
+void monitor_clear(void) {
+	stats.overruns = 0;
+	for (uint8_t i = 0; i < NUM_PHASES; i++) {
+		stats.phase_overruns[i] = 0;
+	}
+	stats.slowest_us = 0;
+	stats.slowest_phase = PHASE_INPUT;
+}
+
+void monitor_start_pass(LoopPhase phase) {
+	pass_start = get_current_time_us();
+	phase_start = pass_start;
+	current_phase = phase;
+	for (uint8_t i = 0; i < NUM_PHASES; i++) {
+		phase_us[i] = 0;
+	}
+}
+
+void monitor_phase(LoopPhase phase) {
+	uint32_t now = get_current_time_us();
+	phase_us[current_phase] += now - phase_start;
+	phase_start = now;
+	current_phase = phase;
+}
+
+void monitor_end_pass(void) {
+	monitor_phase(current_phase);
+	wdt_reset();
+
+	uint32_t pass_us = phase_start - pass_start;
+	if (pass_us <= budget_us) {
+		return;
+	}
+	LoopPhase slowest = PHASE_INPUT;
+	for (uint8_t i = 1; i < NUM_PHASES; i++) {
+		if (phase_us[i] > phase_us[slowest]) {
+			slowest = i;
+		}
+	}
+	stats.overruns++;
+	stats.phase_overruns[slowest]++;
+	if (pass_us > stats.slowest_us) {
+		stats.slowest_us = (pass_us > 0xFFFF) ? 0xFFFF : pass_us;
+		stats.slowest_phase = slowest;
+	}
+}
+
+void monitor_get_stats(LoopStats* result) {
+	*result = stats;
+}
+
+const char* monitor_phase_name(LoopPhase phase) {
+	return (const char*) pgm_read_word(&phase_names[phase]);
+}
+
+ResetReason monitor_last_reset(void) {
+	return last_reset;
+}
+
+uint16_t monitor_reset_count(ResetReason reason) {
+	uint16_t count = storage_read_word(RESET_COUNTS_ADDRESS + 2 * reason);
+	return (count == 0xFFFF) ? 0 : count;
+}
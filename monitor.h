@@ -0,0 +1,82 @@
+/*
+ * monitor.h
+ *
+ * Author: Arjun Srikanth
+ *
+ * Keeps an eye on the game loop. Each pass of the loop is timed (see
+ * get_current_time_us() in timer0.h) and split into phases. A pass which
+ * takes longer than the budget is counted as an overrun against the phase
+ * which took longest in that pass. Sleeping at the end of a pass (see
+ * power.h) doesn't count towards the budget.
+ *
+ * The hardware watchdog resets the AVR if nothing resets it for a second,
+ * e.g. if the loop is stuck in uart1_write() waiting for room to send to
+ * the other unit, or in snapshot_wait() for an EEPROM write which never
+ * finishes. The end of every pass resets it, and so must any other code
+ * which waits for a long time (wdt_reset() from avr/wdt.h). The cause of
+ * every reset is counted in EEPROM.
+ */
+
+
+#ifndef MONITOR_H_
+#define MONITOR_H_
+
+#include <stdint.h>
+
+typedef enum {
+	PHASE_INPUT,	// buttons, keys, remote commands and the link
+	PHASE_LOGIC,	// scheduled tasks and game rules
+	PHASE_RENDER,	// LED matrix and seven segment display
+	PHASE_SERIAL,	// terminal and telemetry output
+	NUM_PHASES
+} LoopPhase;
+
+typedef enum {
+	RESET_POWER_ON,
+	RESET_PIN,
+	RESET_BROWN_OUT,
+	RESET_WATCHDOG,
+	NUM_RESET_REASONS
+} ResetReason;
+
+// Budget for each pass of the game loop unless it is changed
+#define MONITOR_DEFAULT_BUDGET_US 4000
+
+// Overruns of the budget since monitor_clear() was last called
+typedef struct {
+	uint16_t overruns;
+	uint16_t phase_overruns[NUM_PHASES];
+	uint16_t slowest_us;		// longest pass
+	LoopPhase slowest_phase;	// phase which took longest in that pass
+} LoopStats;
+
+// Count the reason for the last reset and start the watchdog. Should be
+// called first thing in main().
+void monitor_init(void);
+
+// Set the budget for each pass of the game loop
+void monitor_set_budget(uint16_t budget_us);
+
+// Forget overruns, e.g. at the start of a game
+void monitor_clear(void);
+
+// Mark the start of a pass of the game loop (and of its first phase)
+void monitor_start_pass(LoopPhase phase);
+
+// Mark the start of the next phase of the pass
+void monitor_phase(LoopPhase phase);
+
+// Mark the end of a pass - checks the budget and resets the watchdog
+void monitor_end_pass(void);
+
+void monitor_get_stats(LoopStats* stats);
+
+// Name of a phase (in program memory) for reports
+const char* monitor_phase_name(LoopPhase phase);
+
+// Reason for the last reset, and number of resets for a reason since the
+// EEPROM was erased
+ResetReason monitor_last_reset(void);
+uint16_t monitor_reset_count(ResetReason reason);
+
+#endif /* MONITOR_H_ */
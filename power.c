@@ -0,0 +1,50 @@
+/*
+ * power.c
+ *
+ * Author: Arjun Srikanth
+ */
+
+#include "power.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include "timer0.h"
+
+// Microseconds spent asleep since window_start, and the result of the last
+// complete window
+static uint32_t asleep_us;
+static uint32_t window_start;
+static uint16_t awake_permille = 1000;
+
+void power_idle(bool (*work_pending)(void)) {
+	uint32_t current_time = get_current_time();
+	uint32_t elapsed = current_time - window_start;
+	if (elapsed >= POWER_WINDOW_MS) {
+		// Microseconds divided by milliseconds gives tenths of a percent
+		uint32_t asleep = asleep_us / elapsed;
+		awake_permille = (asleep > 1000) ? 0 : 1000 - asleep;
+		asleep_us = 0;
+		window_start = current_time;
+	}
+
+	set_sleep_mode(SLEEP_MODE_IDLE);
+	// Interrupts stay off from checking for work until the instruction
+	// after sei(), so an interrupt can't sneak in between deciding to
+	// sleep and sleeping
+	cli();
+	if (work_pending()) {
+		sei();
+		return;
+	}
+	uint32_t start = get_current_time_us();
+	sleep_enable();
+	sei();
+	sleep_cpu();
+	sleep_disable();
+	asleep_us += get_current_time_us() - start;
+}
+
+uint16_t power_awake_permille(void) {
+	return awake_permille;
+}
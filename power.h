@@ -0,0 +1,37 @@
+/*
+ * power.h
+ *
+ * Author: Arjun Srikanth
+ *
+ * Idle sleep between events. Every interrupt the game relies on (the timer
+ * 0 millisecond tick, which also samples the buttons, the seven segment
+ * multiplexing on timer 1, and the serial ports) wakes the CPU from idle
+ * sleep, so a loop can sleep at the end of each pass without missing
+ * anything - the next pass starts within a millisecond. The time spent
+ * asleep is measured so the fraction of time the CPU is awake (its duty
+ * cycle) can be reported.
+ */
+
+
+#ifndef POWER_H_
+#define POWER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Time (in milliseconds) over which the duty cycle is measured
+#define POWER_WINDOW_MS 1000
+
+// Sleep until the next interrupt, unless work_pending() returns true.
+// work_pending() is called with interrupts off, so anything an interrupt
+// delivers after it has looked wakes the CPU straight away instead of
+// waiting for the interrupt after.
+void power_idle(bool (*work_pending)(void));
+
+// Return the fraction of time (in tenths of a percent) the CPU was awake
+// over the last complete window (1000 until the first window has finished).
+// Windows are only finished by power_idle(), so a window may be longer
+// than POWER_WINDOW_MS if the CPU was busy.
+uint16_t power_awake_permille(void);
+
+#endif /* POWER_H_ */
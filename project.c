@@ -9,11 +9,13 @@
 
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <avr/io.h>
 #include <avr/interrupt.h>
 #include <avr/pgmspace.h>
+#include <avr/wdt.h>
 
 #define F_CPU 8000000UL
 #include <util/delay.h>
@@ -25,6 +27,24 @@
 #include "serialio.h"
 #include "terminalio.h"
 #include "timer0.h"
+#include "animation.h"
+#include "terminal_board.h"
+#include "hud.h"
+#include "format.h"
+#include "telemetry.h"
+#include "remote.h"
+#include "benchmark.h"
+#include "input.h"
+#include "boards.h"
+#include "link.h"
+#include "uart1.h"
+#include "scheduler.h"
+#include "pt.h"
+#include "power.h"
+#include "countdown.h"
+#include "monitor.h"
+#include "snapshot.h"
+#include "memory.h"
 
 // Function prototypes - these are defined below (after main()) in the order
 // given here
@@ -36,6 +56,34 @@ void play_game(void);
 void two_play_game(void);
 void game_pause(void);
 void handle_game_over(void);
+void show_time_left(uint8_t player);
+void show_dice_and_moves(void);
+void report_telemetry(bool player_2_turn, uint32_t current_time);
+void take_turn(uint8_t num_spaces);
+void handle_action(InputAction action);
+void record_button_latency(uint32_t push_time);
+void run_remote_command(const RemoteCommand* command, bool in_game);
+void get_game_state(uint8_t* state, bool in_game);
+bool linked_game(void);
+void service_link(uint32_t current_time);
+void move_by_action(InputAction direction, bool player_1);
+void start_game_tasks(void);
+void flash_tokens(void);
+void roll_dice_task(void);
+void set_game_clocks(void);
+void run_turn_clock(void);
+void save_game(void);
+void restore_game(const uint8_t* snapshot);
+void handle_game_input(void);
+void collect_game_input(void);
+bool take_queued_pause(void);
+void run_flow(char (*flow)(Protothread* pt));
+void ui_service(void);
+char start_screen_flow(Protothread* pt);
+char pause_flow(Protothread* pt);
+char game_over_flow(Protothread* pt);
+void show_duty_cycle(void);
+bool work_pending(void);
 
 // Check if player has moved (for player flash implementation)
 bool player_moved = false;
@@ -48,53 +96,148 @@ bool start_roll = false;
 // Two player game - true/false
 bool two_player_game = false;
 
+// Two player game turns. True = move player 1, False = move player 2
+bool move_player_1 = true;
+
+// Count moves separately
+uint8_t player_1_moves = 0;
+uint8_t player_2_moves = 0;
+
 // Board number (board select)
+// (see boards.h for the numbering of stored boards)
 uint8_t board_number;
-static const uint8_t TOTAL_BOARDS = 2;
 
 // Difficulty select
 uint8_t difficulty;
 
+// Scheduler task which flashes the player tokens (see start_game_tasks())
+TaskId flash_task;
+
+// Time the current pass of the game loop (or of a UI flow) started, so
+// work_pending() can tell whether a tick has happened since
+uint32_t pass_time;
+
+// Input for the UI flows (start, pause and game over screens), collected
+// by ui_service() on every pass - the next character typed (-1 if there
+// isn't one) and the next button pushed (or NO_BUTTON_PUSHED)
+char ui_key;
+int8_t ui_button;
+
+// Actions from buttons and keys waiting to be carried out, oldest first.
+// Input is collected here while the game is paused too, so nothing is lost
+// - the pause screen only takes the action which ends the pause, and the
+// rest are carried out when the game carries on. Input which doesn't fit
+// is left in the button and serial input buffers until there is room.
+#define ACTION_QUEUE_SIZE SERIAL_INPUT_BUFFER_SIZE
+InputAction action_queue[ACTION_QUEUE_SIZE];
+uint8_t action_head;
+uint8_t action_count;
+
+// Which part of the session is running (see main()). The game is paused
+// when session_state is SESSION_PAUSED, and pause_state is the state of
+// the pause screen.
+typedef enum {
+	SESSION_START,
+	SESSION_PLAYING,
+	SESSION_PAUSED,
+	SESSION_GAME_OVER
+} SessionState;
+SessionState session_state;
+Protothread pause_state;
+uint32_t pause_time;
+
 // Timed game forfeit booleans
 bool p1_wins = false;
 bool p2_wins = false;
 
+// Longest time (in milliseconds) between a button push being recognised
+// and the game acting on it, this game
+uint16_t max_button_latency;
+
+// Values last shown on the terminal by show_time_left() and
+// show_dice_and_moves(), reset by new_game() when the terminal is cleared
+static uint8_t shown_player;
+static char shown_digits[COUNTDOWN_DIGITS];
+static uint8_t shown_dice;
+static uint8_t shown_moves;
+
+// CPU duty cycle last shown on the start screen (see show_duty_cycle())
+static uint16_t shown_awake;
+
 /////////////////////////////// main //////////////////////////////////
 int main(void) {
+	// Count why we were reset and start the watchdog
+	monitor_init();
+
 	// Setup hardware and call backs. This will turn on 
 	// interrupts.
 	initialise_hardware();
-	
-	// Show the splash screen message. Returns when display
-	// is complete.
-	two_player_game = false;
 	board_number = 1;
 	difficulty = 0;
-	p1_wins = false;
-	p2_wins = false;
-	start_screen();
+
+	// Carry on with a game which was cut off by a reset or power cut
+	uint8_t snapshot[SNAPSHOT_SIZE];
+	bool resume = snapshot_load(snapshot)
+			&& (snapshot[SNAPSHOT_FLAGS] & SNAPSHOT_IN_PROGRESS);
+	session_state = SESSION_START;
+	if (resume) {
+		two_player_game = snapshot[SNAPSHOT_FLAGS] & SNAPSHOT_TWO_PLAYER;
+		board_number = snapshot[SNAPSHOT_BOARD];
+		difficulty = snapshot[SNAPSHOT_DIFFICULTY];
+		p1_wins = false;
+		p2_wins = false;
+		session_state = SESSION_PLAYING;
+	}
 	
-	// Loop forever and continuously play the game.
+	// Loop forever, moving from one part of the session to the next. Each
+	// part returns here when it is finished, so the stack doesn't grow
+	// however many games are played.
 	while(1) {
-		new_game();
-		if (two_player_game)
-		{
-			two_play_game();
-		}else {
-			play_game();
+		switch (session_state) {
+			case SESSION_START:
+				// Show the splash screen message. Returns when a game
+				// has been chosen.
+				two_player_game = false;
+				p1_wins = false;
+				p2_wins = false;
+				start_screen();
+				session_state = SESSION_PLAYING;
+				break;
+			case SESSION_PLAYING:
+			case SESSION_PAUSED:
+				new_game();
+				if (resume) {
+					restore_game(snapshot);
+					resume = false;
+				}
+				if (two_player_game) {
+					two_play_game();
+				} else {
+					play_game();
+				}
+				session_state = SESSION_GAME_OVER;
+				break;
+			case SESSION_GAME_OVER:
+				handle_game_over();
+				session_state = SESSION_START;
+				break;
 		}
-		handle_game_over();
 	}
 }
 
 void initialise_hardware(void) {
 	ledmatrix_setup();
 	init_button_interrupts();
-	// Setup serial port for 19200 baud communication with no echo
-	// of incoming characters
-	init_serial_stdio(19200,0);
+	// Setup serial port for SERIAL_BAUD (see serialio.h) communication
+	// with no echo of incoming characters
+	init_serial_stdio(SERIAL_BAUD,0);
+	remote_init();
+	input_reset_bindings();
+	init_uart1(LINK_BAUD);
+	link_init();
 	
 	init_timer0();
+	init_seven_seg();
 	
 	// Turn on global interrupts
 	sei();
@@ -120,6 +263,21 @@ void terminal_start_screen(void) {
 	move_terminal_cursor(10, 20);
 	
 	printf_P(PSTR("BOARD: %d"), board_number);
+	if (boards_is_stored(board_number)) {
+		printf_P(PSTR(" (stored)"));
+	}
+	move_terminal_cursor(10, 21);
+	printf_P(PSTR("Stored boards:"));
+	bool any_stored = false;
+	for (uint8_t slot = 0; slot < BOARD_SLOTS; slot++) {
+		if (boards_slot_valid(slot)) {
+			printf_P(PSTR(" %d"), BUILT_IN_BOARDS + 1 + slot);
+			any_stored = true;
+		}
+	}
+	if (!any_stored) {
+		printf_P(PSTR(" none"));
+	}
 
 	move_terminal_cursor(10, 22);
 	printf_P(PSTR("For easy difficulty, press 'e'/'E'"));
@@ -128,458 +286,978 @@ void terminal_start_screen(void) {
 	move_terminal_cursor(10, 24);
 	printf_P(PSTR("For hard difficulty, press 'h'/'H'"));
 
+	move_terminal_cursor(10, 26);
+	if (telemetry_enabled()) {
+		printf_P(PSTR("Press 't'/'T' to toggle binary telemetry: ON"));
+	} else {
+		printf_P(PSTR("Press 't'/'T' to toggle binary telemetry: OFF"));
+	}
+
+	// The baud rate error can't be shown when the serial port is set up
+	// (interrupts are still off), so it is shown here
+	move_terminal_cursor(10, 28);
+	print_baud_rate();
+	move_terminal_cursor(10, 29);
+	printf_P(PSTR("Press 'u'/'U' to benchmark the serial port"));
+	move_terminal_cursor(10, 30);
+	printf_P(PSTR("Press 'r'/'R' to show memory use"));
+
+	move_terminal_cursor(10, 31);
+	if (link_state() == LINK_INVITING) {
+		printf_P(PSTR("Waiting for the other unit to join..."));
+	} else {
+		printf_P(PSTR("Press 'l'/'L' to play against another unit"));
+	}
+
+	show_duty_cycle();
+
+	move_terminal_cursor(10, 34);
+	printf_P(PSTR("Resets: power %u, pin %u, brown-out %u, watchdog %u"),
+			monitor_reset_count(RESET_POWER_ON), monitor_reset_count(RESET_PIN),
+			monitor_reset_count(RESET_BROWN_OUT),
+			monitor_reset_count(RESET_WATCHDOG));
+	if (monitor_last_reset() == RESET_WATCHDOG) {
+		move_terminal_cursor(10, 35);
+		printf_P(PSTR("Restarted by the watchdog - the game stopped responding"));
+	}
+}
+
+// Show how much of the time the CPU is awake (see power.h) on the start
+// and game over screens
+void show_duty_cycle(void) {
+	shown_awake = power_awake_permille();
+	move_terminal_cursor(10, 33);
+	printf_P(PSTR("CPU awake: %u.%u%% of the time  "), shown_awake / 10,
+			shown_awake % 10);
 }
 
 void start_screen(void) {
+	run_flow(start_screen_flow);
+}
+
+// The start screen - waits for a game to be chosen, while other keys
+// change the settings
+char start_screen_flow(Protothread* pt) {
+	PT_BEGIN(pt);
 	// Clear terminal screen and output a message
 	terminal_start_screen();
 	// Output the static start screen and wait for a push button 
 	// to be pushed or a serial input of 's'
 	start_display();
+
+	// Any previous link has finished - listen for invitations from
+	// another unit
+	link_init();
+	uart1_clear_input();
 	
 	// Wait until a button is pressed, or 's' is pressed on the terminal
 	while(1) {
-		// First check for if a 's' is pressed
-		// There are two steps to this
-		// 1) collect any serial input (if available)
-		// 2) check if the input is equal to the character 's'
-		
-		seven_seg_display(moves, dice_value); // Display 00 during start_screen
+		PT_YIELD(pt);
 
-		char serial_input = -1;
-		if (serial_input_available()) {
-			serial_input = fgetc(stdin);
+		// The duty cycle changes at most once a second
+		if (power_awake_permille() != shown_awake) {
+			show_duty_cycle();
+		}
+
+		RemoteCommand command;
+		if (remote_get_command(&command)) {
+			run_remote_command(&command, false);
+			if (command.type == REMOTE_BOARD_FINISH) {
+				// Show the new list of stored boards
+				terminal_start_screen();
+			}
+		}
+
+		// Another unit has accepted our invitation, or invited us. The
+		// unit which invited chooses the board, and linked games are
+		// untimed as each unit keeps its own time.
+		service_link(get_current_time());
+		if (link_state() == LINK_CONNECTED) {
+			two_player_game = true;
+			board_number = link_board_number();
+			difficulty = 0;
+			PT_EXIT(pt);
 		}
+
+		if (ui_key == 'l' || ui_key == 'L') {
+			// The nonce comes from the microsecond clock (which counts
+			// in steps of 8us) when the key was pressed, which the
+			// other unit can't share even if both were started together
+			uint32_t key_time = get_current_time_us() >> 3;
+			link_invite(board_number, key_time ^ (key_time >> 8),
+					get_current_time());
+			terminal_start_screen();
+		}
+
 		// If the serial input is 's', then exit the start screen
 		// Start a single player game
-		if (serial_input == 's' || serial_input == 'S' || serial_input == '1') {
-			break;
+		if (ui_key == 's' || ui_key == 'S' || ui_key == '1') {
+			PT_EXIT(pt);
 		}
 
 		// If the serial input is '2', then start a two player game
-		if (serial_input == '2') {
+		if (ui_key == '2') {
 			two_player_game = true;
-			break;
+			PT_EXIT(pt);
 		}
 
-		if (serial_input == 'b' || serial_input == 'B') {
-			if (board_number == TOTAL_BOARDS) {
-				board_number = 1;
-			} else {
-				board_number += 1;
-			}
+		if (ui_key == 'b' || ui_key == 'B') {
+			board_number = boards_next(board_number);
+			terminal_start_screen();
+		}
+
+		if (ui_key == 't' || ui_key == 'T') {
+			telemetry_set_enabled(!telemetry_enabled());
+			terminal_start_screen();
+		}
+
+		if (ui_key == 'u' || ui_key == 'U') {
+			run_serial_benchmark();
+			// Wait for the next key or button (not the 'u')
+			PT_YIELD(pt);
+			PT_WAIT_UNTIL(pt, ui_key != -1 || ui_button != NO_BUTTON_PUSHED);
+			terminal_start_screen();
+			continue;
+		}
+
+		if (ui_key == 'r' || ui_key == 'R') {
+			clear_terminal();
+			memory_print_report(10, 10);
+			move_terminal_cursor(10, 8);
+			printf_P(PSTR("Press a key or button to return"));
+			// Wait for the next key or button (not the 'r')
+			PT_YIELD(pt);
+			PT_WAIT_UNTIL(pt, ui_key != -1 || ui_button != NO_BUTTON_PUSHED);
 			terminal_start_screen();
+			continue;
 		}
 
-		if (serial_input == 'e' || serial_input == 'E') {
+		if (ui_key == 'e' || ui_key == 'E') {
 			difficulty = 0;
 		}
 
-		if (serial_input == 'm' || serial_input == 'M') {
+		if (ui_key == 'm' || ui_key == 'M') {
 			difficulty = 1;
 		}
 
-		if (serial_input == 'h' || serial_input == 'H') {
+		if (ui_key == 'h' || ui_key == 'H') {
 			difficulty = 2;
 		}
 
-		// Next check for any button presses
-		int8_t btn = button_pushed();
-		if (btn != NO_BUTTON_PUSHED) {
-			break;
+		// Any button starts a single player game
+		if (ui_button != NO_BUTTON_PUSHED) {
+			PT_EXIT(pt);
 		}
 	}
+	PT_END(pt);
 }
 
 void new_game(void) {
-	// Clear the serial terminal
+	// Clear the serial terminal and draw the empty board mirror on it,
+	// unless the serial port is being used for telemetry instead
 	clear_terminal();
+	if (telemetry_enabled()) {
+		terminal_board_disable();
+		hud_disable();
+	} else {
+		terminal_board_init();
+		hud_init();
+	}
+	telemetry_start();
+	shown_player = 0xFF;
+	shown_dice = 0xFF;
+	shown_moves = 0xFF;
 	
 	// Initialise the game and display
 	initialise_game(two_player_game, board_number);
+	set_game_clocks();
+	move_player_1 = true;
+	player_1_moves = 0;
+	player_2_moves = 0;
+	// moves = player_1_moves or player_2_moves
+	moves = 0;
+	dice_value = 0;
+	if (linked_game()) {
+		link_send_board(board_checksum());
+	}
 	
 	// Clear a button push or serial input if any are waiting
 	// (The cast to void means the return value is ignored.)
-	(void)button_pushed();
+	clear_button_pushes();
 	clear_serial_input_buffer();
+	action_count = 0;
+	serial_clear_input_stats();
+	max_button_latency = 0;
+	monitor_clear();
+
+	// From here on, terminal output is discarded rather than holding up
+	// the game if the terminal can't keep up
+	serial_set_output_nonblocking(1);
 }
 
 void play_game(void) {
-	
-	uint32_t last_flash_time, current_time;
-	uint32_t last_roll_time; // Last time roll_dice() was called
-
-	// last_decrement_time - records last time the player_game_time was decremented
-	// player_game_time - is the total time the player has to complete the game
-	uint32_t last_decrement_time, player_game_time;
+	uint32_t current_time;
 
-	uint8_t btn; // The button pushed
-	
-	last_flash_time = get_current_time();
-	last_roll_time = get_current_time();
-	last_decrement_time = get_current_time();
-	
-	if (difficulty == 1) {
-		player_game_time = 90000;
-	} else if (difficulty == 2) {
-		player_game_time = 45000;
-	} else {
-		player_game_time = 45000000; // 12.5 hours
-	}
-	moves = 0;
-	dice_value = 0;
+	start_game_tasks();
+	run_turn_clock();
 
-	// We play the game until it's over
-	while(!is_game_over()) {
+	// We play the game until it's over (and the winning move has finished
+	// being animated)
+	while(!is_game_over() || animation_in_progress()) {
 				
-		// We need to check if any button has been pushed, this will be
-		// NO_BUTTON_PUSHED if no button has been pushed
-		btn = button_pushed();
-		
-		if ((btn == BUTTON0_PUSHED) & !start_roll) {
-			// If button 0 is pushed, move the player 1 space forward
-			// YOU WILL NEED TO IMPLEMENT THIS FUNCTION
-			move_player_n(1, true);
-			moves+=1;
+		current_time = get_current_time();
+		pass_time = current_time;
+		monitor_start_pass(PHASE_RENDER);
+		animation_update(current_time);
+
+		monitor_phase(PHASE_INPUT);
+		// While the game is paused input is only collected - the pause
+		// screen waits for the action which carries on the game
+		if (session_state == SESSION_PAUSED) {
+			collect_game_input();
+			if (!PT_SCHEDULE(pause_flow(&pause_state))) {
+				session_state = SESSION_PLAYING;
+				run_turn_clock();
+			}
+		} else {
+			handle_game_input();
 		}
 
-		if ((btn == BUTTON1_PUSHED) & !start_roll) {
-			move_player_n(2, true);
-			moves+=1;
+		monitor_phase(PHASE_LOGIC);
+		// Hold player flash for 500ms after movement
+		if (player_moved) {
+			scheduler_restart(flash_task, current_time);
 		}
-
-		char serial_input = -1;
-		if (serial_input_available()) {
-			serial_input = fgetc(stdin);
+		player_moved = false;
+		if (session_state == SESSION_PLAYING) {
+			scheduler_run(current_time);
 		}
 
-		if (btn == BUTTON3_PUSHED || serial_input == 'p' || serial_input == 'P') {
-			game_pause();
+		if (difficulty > 0 && countdown_expired(COUNTDOWN_P1)) {
+			break;
 		}
 
-		if ((serial_input == 's' || serial_input == 'S') & !start_roll) {
-			move_player(0, -1, true);
-			player_moved = true;
-		}
+		snake_ladder_func(true);
+		monitor_phase(PHASE_RENDER);
+		seven_seg_display(moves, dice_value);
+		display_render();
 
-		if ((serial_input == 'w' || serial_input == 'W') & !start_roll) {
-			move_player(0, 1, true);
-			player_moved = true;
+		monitor_phase(PHASE_SERIAL);
+		show_dice_and_moves();
+		if (difficulty > 0) {
+			show_time_left(0);
 		}
+		report_telemetry(false, current_time);
+		monitor_end_pass();
 
-		if ((serial_input == 'd' || serial_input == 'D') & !start_roll) {
-			move_player(1, 0, true);
-			player_moved = true;
-		}
+		// Nothing more to do until the next interrupt
+		power_idle(work_pending);
+	}
+	// We get here if the game is over - main() shows the game over screen
+}
 
-		if ((serial_input == 'a' || serial_input == 'A') & !start_roll) {
-			move_player(-1, 0, true);
-			player_moved = true;
-		}
+void two_play_game(void) {
+	uint32_t current_time;
 
+	start_game_tasks();
+	run_turn_clock();
+	
+	while(!is_game_over() || animation_in_progress()) {
+	
 		current_time = get_current_time();
-
-		if (((btn == BUTTON2_PUSHED)|(serial_input == 'r' || serial_input == 'R')) & !start_roll) {
-			start_roll = true;
-			clear_terminal();
-			move_terminal_cursor(10, 14);
-			printf_P(PSTR("Dice Rolling..."));
-		}else if (((btn == BUTTON2_PUSHED)|(serial_input == 'r' || serial_input == 'R')) & start_roll) {
-			start_roll = false;
-			clear_terminal();
-			move_terminal_cursor(10, 14);
-			printf_P(PSTR("Dice Stopped. Value: %d"), dice_value);
-			move_player_n(dice_value, true);
-			moves += 1;
-		}
-
-		if (start_roll) {
-			if (current_time >= last_roll_time + 100) {
-				dice_value = roll_dice();
-				last_roll_time = current_time;
+		pass_time = current_time;
+		monitor_start_pass(PHASE_RENDER);
+		animation_update(current_time);
+
+		monitor_phase(PHASE_INPUT);
+		// While the game is paused input is only collected - the pause
+		// screen waits for the action which carries on the game
+		if (session_state == SESSION_PAUSED) {
+			collect_game_input();
+			if (!PT_SCHEDULE(pause_flow(&pause_state))) {
+				session_state = SESSION_PLAYING;
+				run_turn_clock();
 			}
+		} else {
+			handle_game_input();
 		}
 
-		if (player_game_time < 100) {
-			break;
-		}
-
-		if (current_time >= last_decrement_time + 100) {
-			player_game_time -= 100;
-			last_decrement_time = current_time;
+		// Make the moves made on the other unit of a linked game
+		if (linked_game()) {
+			service_link(current_time);
+			LinkTurn turn;
+			while (link_get_turn(&turn)) {
+				bool other_player_1 = !link_is_player_1();
+				if (turn.action == LINK_ACTION_STEP) {
+					move_by_action(turn.value, other_player_1);
+					player_moved = true;
+				} else {
+					if (turn.action == LINK_ACTION_ROLL) {
+						dice_value = turn.value;
+					}
+					take_turn(turn.value);
+				}
+				uint8_t state[REMOTE_STATE_SIZE];
+				get_game_state(state, true);
+				link_check_hash(turn.hash, frame_crc16(state, REMOTE_STATE_SIZE));
+			}
+			if (link_state() != LINK_CONNECTED) {
+				break;
+			}
 		}
 
+		monitor_phase(PHASE_LOGIC);
 		// Hold player flash for 500ms after movement
 		if (player_moved) {
-			current_time = 0;
+			scheduler_restart(flash_task, current_time);
 		}
-		if (current_time >= last_flash_time + 500) {
-			// 500ms (0.5 second) has passed since the last time we
-			// flashed the cursor, so flash the cursor
-			flash_player_cursor();
-			
-			// Update the most recent time the cursor was flashed
-			last_flash_time = current_time;
+		player_moved = false;
+		if (session_state == SESSION_PLAYING) {
+			scheduler_run(current_time);
 		}
 
-		player_moved = false;
+		if (difficulty > 0 && countdown_expired(COUNTDOWN_P1)) {
+			p2_wins = true;
+			break;
+		} else if(difficulty > 0 && countdown_expired(COUNTDOWN_P2)) {
+			p1_wins = true;
+			break;
+		}
 
-		snake_ladder_func(true);
+		snake_ladder_func(move_player_1);
+		monitor_phase(PHASE_RENDER);
+		// Shows previous player's no. of moves
 		seven_seg_display(moves, dice_value);
+		display_render();
 
+		monitor_phase(PHASE_SERIAL);
+		show_dice_and_moves();
 		if (difficulty > 0) {
-			move_terminal_cursor(10, 16);
-			printf_P(PSTR("Time Left: %d"), player_game_time/1000);
-			if (player_game_time < 10000){
-				move_terminal_cursor(22, 16);
-				printf_P(PSTR(".%d"), (player_game_time%1000)/100);
+			if (move_player_1){
+				show_time_left(1);
+			} else {
+				show_time_left(2);
 			}
 		}
+		report_telemetry(!move_player_1, current_time);
+		monitor_end_pass();
+
+		// Nothing more to do until the next interrupt
+		power_idle(work_pending);
 	}
-	// We get here if the game is over.
-	handle_game_over();
+	// We get here if the game is over - main() shows the game over screen
 }
 
-void two_play_game(void) {
-	uint32_t last_flash_time, current_time;
-	uint32_t last_roll_time; // Last time roll_dice() was called
-	
-	// pn_last_decrement_time - records last time the player_game_time was decremented
-	// pn_player_game_time - is the time the player has to complete the game
-	uint32_t p1_last_decrement_time, p1_game_time;
-	uint32_t p2_last_decrement_time, p2_game_time;
+// Pause the game. The game loop runs the pause screen (pause_flow())
+// until the game carries on.
+void game_pause(void) {
+	session_state = SESSION_PAUSED;
+	PT_INIT(&pause_state);
+	run_turn_clock();
+}
 
-	uint8_t btn; // The button pushed
-	
-	last_flash_time = get_current_time();
-	last_roll_time = get_current_time();
-	p1_last_decrement_time = get_current_time();
-	p2_last_decrement_time = get_current_time();
+// The pause screen - waits for 'p' to be pressed again. Other input is
+// kept for when the game carries on (see action_queue).
+char pause_flow(Protothread* pt) {
+	PT_BEGIN(pt);
+	pause_time = get_current_time();
+	hud_set_P(HUD_MESSAGE, PSTR("GAME PAUSED. Press 'p'/'P' to continue game"));
+	PT_WAIT_UNTIL(pt, take_queued_pause());
+	hud_set_P(HUD_MESSAGE, PSTR(""));
+	// The game's clocks stop while it is paused
+	scheduler_delay(get_current_time() - pause_time);
+	PT_END(pt);
+}
 
-	if (difficulty == 1) {
-		p1_game_time = 90000;
-		p2_game_time = 90000;
-	} else if (difficulty == 2) {
-		p1_game_time = 45000;
-		p2_game_time = 45000;
+void handle_game_over() {
+	// The game can't be carried on after a reset now
+	save_game();
+	run_flow(game_over_flow);
+}
+
+// The game over screen - shows who won and waits for a button or 's'
+char game_over_flow(Protothread* pt) {
+	PT_BEGIN(pt);
+	terminal_board_disable();
+	serial_set_output_nonblocking(0);
+	if (telemetry_enabled()) {
+		uint8_t result = TELEMETRY_GAME_OVER;
+		if (is_game_over() == 1 || p1_wins) {
+			result |= TELEMETRY_P1_WINS;
+		} else if (is_game_over() == 2 || p2_wins) {
+			result |= TELEMETRY_P2_WINS;
+		}
+		telemetry_send_final(result);
 	} else {
-		p1_game_time = 45000000; // 12.5 hours
-		p2_game_time = 45000000; 
+		clear_terminal();
+		move_terminal_cursor(10,14);
+		printf_P(PSTR("GAME OVER"));
+		move_terminal_cursor(10,15);
+		if (is_game_over() == 1 || p1_wins) {
+			printf_P(PSTR("Player 1 Wins!!"));
+		} else if (is_game_over() == 2 || p2_wins){
+			printf_P(PSTR("Player 2 Wins!!"));
+		} else if (linked_game() && link_state() == LINK_DESYNCED) {
+			printf_P(PSTR("No one wins - the units got out of step"));
+		} else if (linked_game() && link_state() == LINK_LOST) {
+			printf_P(PSTR("No one wins - the other unit stopped answering"));
+		} else {
+			printf_P(PSTR("No one wins :("));
+		}
+		move_terminal_cursor(10,16);
+		printf_P(PSTR("Press a button or 's'/'S' to start again"));
+
+		// Report any serial input that was lost during the game
+		SerialInputStats input_stats;
+		serial_get_input_stats(&input_stats);
+		if (input_stats.overruns) {
+			move_terminal_cursor(10,18);
+			printf_P(PSTR("Serial input lost: %u characters (most waiting: %u)"),
+					input_stats.overruns, input_stats.high_water);
+		}
+		move_terminal_cursor(10,19);
+		printf_P(PSTR("Slowest button response: %u ms (%u pushes lost)"),
+				max_button_latency, button_overruns());
+		LoopStats loop_stats;
+		monitor_get_stats(&loop_stats);
+		if (loop_stats.overruns) {
+			move_terminal_cursor(10,20);
+			printf_P(PSTR("Slow game loops: %u (slowest %u us, in %S)"),
+					loop_stats.overruns, loop_stats.slowest_us,
+					monitor_phase_name(loop_stats.slowest_phase));
+		}
+		show_duty_cycle();
 	}
-	
-	// True = move player 1, False = move player 2
-	bool move_player_1 = true;
 
-	// Count moves separately
-	uint8_t player_1_moves = 0;
-	uint8_t player_2_moves = 0;
-	
-	// moves = player_1_moves or player_2_moves
-	moves = player_1_moves;
-	dice_value = 0;
-	
-	while(!is_game_over()) {
-	
-		// We need to check if any button has been pushed, this will be
-		// NO_BUTTON_PUSHED if no button has been pushed
-		btn = button_pushed();
-		
-		if ((btn == BUTTON0_PUSHED) & !start_roll) {
-			// If button 0 is pushed, move the player 1 space forward
-			// YOU WILL NEED TO IMPLEMENT THIS FUNCTION
-			move_player_n(1, move_player_1);
-			move_player_1 = !move_player_1;
-
-			if (move_player_1) {
-				player_1_moves += 1;
-				moves = player_1_moves;
-			} else {
-				player_2_moves += 1;
-				moves = player_2_moves;
-			}
-		}
+	PT_WAIT_UNTIL(pt, ui_key == 's' || ui_key == 'S'
+			|| ui_button != NO_BUTTON_PUSHED);
+	PT_END(pt);
+}
 
-		if ((btn == BUTTON1_PUSHED) & !start_roll) {
-			move_player_n(2, move_player_1);
-			move_player_1 = !move_player_1;
+// Run a UI flow (see pt.h) until it ends. The displays and input are
+// kept going by ui_service() while the flow waits.
+void run_flow(char (*flow)(Protothread* pt)) {
+	Protothread pt;
+	PT_INIT(&pt);
+	ui_key = -1;
+	ui_button = NO_BUTTON_PUSHED;
+	pass_time = get_current_time();
+	while (PT_SCHEDULE(flow(&pt))) {
+		// The flow is waiting - sleep until something happens
+		wdt_reset();
+		power_idle(work_pending);
+		pass_time = get_current_time();
+		ui_service();
+	}
+}
 
-			if (move_player_1) {
-				player_1_moves += 1;
-				moves = player_1_moves;
-			} else {
-				player_2_moves += 1;
-				moves = player_2_moves;
-			}
+// Returns true if anything has arrived since the current pass looked for
+// input, or a tick has happened (so a task, animation step or ping may be
+// due). Called by power_idle() with interrupts off, so nothing can arrive
+// between this check and going to sleep.
+bool work_pending(void) {
+	return serial_input_available() || button_events_waiting()
+			|| uart1_available() || get_current_time() != pass_time;
+}
 
-		}
+// Done on every pass while a UI flow is running - keep the seven segment
+// display up to date and collect the next character typed and button
+// pushed for the flow (see ui_key and ui_button)
+void ui_service(void) {
+	seven_seg_display(moves, dice_value);
 
-		char serial_input = -1;
-		if (serial_input_available()) {
-			serial_input = fgetc(stdin);
-		}
-		
-		if (btn == BUTTON3_PUSHED || serial_input == 'p' || serial_input == 'P') {
-			game_pause();
-		}
+	ui_key = -1;
+	if (serial_read_input(&ui_key, 1) == 1
+			&& remote_filter_input(&ui_key, 1) == 0) {
+		ui_key = -1; // part of a remote command
+	}
+	ButtonEvent event;
+	ui_button = NO_BUTTON_PUSHED;
+	if (button_get_event(&event)) {
+		ui_button = event.button;
+	}
+}
 
-		if ((serial_input == 's' || serial_input == 'S') & !start_roll) {
-			move_player(0, -1, move_player_1);
-			player_moved = true;
-		}
+// Show the time left on the terminal, to a tenth of a second once there
+// are less than 10 seconds left. player is 1 or 2 in a two player game
+// and 0 otherwise. The text is only built when the time changes, and the
+// HUD only sends the characters which change.
+void show_time_left(uint8_t player) {
+	char digits[COUNTDOWN_DIGITS];
+	countdown_read(player == 2 ? COUNTDOWN_P2 : COUNTDOWN_P1, digits);
+	if (player == shown_player && digits[0] == shown_digits[0]
+			&& digits[1] == shown_digits[1] && digits[2] == shown_digits[2]) {
+		return;
+	}
+	shown_player = player;
+	for (uint8_t i = 0; i < COUNTDOWN_DIGITS; i++) {
+		shown_digits[i] = digits[i];
+	}
 
-		if ((serial_input == 'w' || serial_input == 'W') & !start_roll) {
-			move_player(0, 1, move_player_1);
-			player_moved = true;
-		}
+	char text[HUD_MAX_WIDTH];
+	uint8_t length;
+	if (player == 0) {
+		length = format_string_P(text, 0, PSTR("Time Left: "));
+	} else {
+		length = format_string_P(text, 0, PSTR("P"));
+		length = format_uint(text, length, player, 1);
+		length = format_string_P(text, length, PSTR(" time left: "));
+	}
+	if (digits[0] != '0') {
+		// Whole seconds only - leave off the tenths digit
+		text[length++] = digits[0];
+		text[length++] = digits[1];
+	} else {
+		text[length++] = digits[1];
+		text[length++] = '.';
+		text[length++] = digits[2];
+	}
+	hud_set(HUD_TIMER, text, length);
+}
 
-		if ((serial_input == 'd' || serial_input == 'D') & !start_roll) {
-			move_player(1, 0, move_player_1);
-			player_moved = true;
-		}
+// Show the dice value and number of moves on the terminal if either has
+// changed since they were last shown.
+void show_dice_and_moves(void) {
+	if (dice_value != shown_dice) {
+		shown_dice = dice_value;
+		hud_set_number_P(HUD_DICE, PSTR("Dice: "), dice_value);
+	}
+	if (moves != shown_moves) {
+		shown_moves = moves;
+		hud_set_number_P(HUD_MOVES, PSTR("Moves: "), moves);
+	}
+}
 
-		if ((serial_input == 'a' || serial_input == 'A') & !start_roll) {
-			move_player(-1, 0, move_player_1);
-			player_moved = true;
+// Send the game state as telemetry (if it is turned on). player_2_turn is
+// true if player 2 moves next.
+void report_telemetry(bool player_2_turn, uint32_t current_time) {
+	if (!telemetry_enabled()) {
+		return;
+	}
+	uint8_t state[TELEMETRY_STATE_SIZE];
+	int8_t x, y;
+
+	uint8_t flags = 0;
+	if (two_player_game) {
+		flags |= TELEMETRY_TWO_PLAYER;
+	}
+	if (player_2_turn) {
+		flags |= TELEMETRY_P2_TURN;
+	}
+	if (start_roll) {
+		flags |= TELEMETRY_ROLLING;
+	}
+	if (difficulty > 0) {
+		flags |= TELEMETRY_TIMED;
+	}
+	state[TELEMETRY_FLAGS] = flags;
+
+	get_player_position(true, &x, &y);
+	state[TELEMETRY_P1_POSITION] = x | (y << 4);
+	state[TELEMETRY_P2_POSITION] = TELEMETRY_NO_PLAYER;
+	if (two_player_game) {
+		get_player_position(false, &x, &y);
+		state[TELEMETRY_P2_POSITION] = x | (y << 4);
+	}
+	state[TELEMETRY_DICE] = dice_value;
+	state[TELEMETRY_MOVES] = moves;
+	uint16_t p1_time = 0;
+	uint16_t p2_time = 0;
+	if (difficulty > 0) {
+		p1_time = countdown_tenths(COUNTDOWN_P1);
+		if (two_player_game) {
+			p2_time = countdown_tenths(COUNTDOWN_P2);
 		}
+	}
+	state[TELEMETRY_FIELD_OFFSET(TELEMETRY_P1_TIME)] = p1_time & 0xFF;
+	state[TELEMETRY_FIELD_OFFSET(TELEMETRY_P1_TIME) + 1] = p1_time >> 8;
+	state[TELEMETRY_FIELD_OFFSET(TELEMETRY_P2_TIME)] = p2_time & 0xFF;
+	state[TELEMETRY_FIELD_OFFSET(TELEMETRY_P2_TIME) + 1] = p2_time >> 8;
 
-		current_time = get_current_time();
+	telemetry_update(state, current_time);
+}
 
-		if (((btn == BUTTON2_PUSHED)|(serial_input == 'r' || serial_input == 'R')) & !start_roll) {
-			start_roll = true;
-			clear_terminal();
-			move_terminal_cursor(10, 14);
-			printf_P(PSTR("Dice Rolling..."));
+// Set up the work done regularly while a game is played (see scheduler.h)
+void start_game_tasks(void) {
+	uint32_t current_time = get_current_time();
+	scheduler_init();
+	flash_task = scheduler_add(flash_tokens, 500, current_time);
+	scheduler_add(roll_dice_task, 100, current_time);
+}
 
-		}else if (((btn == BUTTON2_PUSHED)|(serial_input == 'r' || serial_input == 'R')) & start_roll) {
-			start_roll = false;
-			clear_terminal();
-			move_terminal_cursor(10, 14);
-			printf_P(PSTR("Dice Stopped. Value: %d"), dice_value);
-			move_player_n(dice_value, move_player_1);
-			move_player_1 = !move_player_1;
-			if (move_player_1) {
-				player_1_moves += 1;
-				moves = player_1_moves;
-			} else {
-				player_2_moves += 1;
-				moves = player_2_moves;
-			}
-		}
+// Scheduled every 500ms - flash the player tokens on and off
+void flash_tokens(void) {
+	flash_player_cursor();
+	if (two_player_game) {
+		flash_player_2_cursor();
+	}
+}
 
-		if (start_roll) {
-			if (current_time >= last_roll_time + 100) {
-				dice_value = roll_dice();
-				last_roll_time = current_time;
-			}
-		}
+// Scheduled every 100ms - show a new dice value while the dice are rolling
+void roll_dice_task(void) {
+	if (start_roll) {
+		dice_value = roll_dice();
+	}
+}
 
-		if (p1_game_time < 100) {
-			p2_wins = true;
-			break;
-		} else if(p2_game_time < 100) {
-			p1_wins = true;
-			break;
+// Set both players' clocks to the time allowed for the difficulty (they
+// aren't used in untimed games)
+void set_game_clocks(void) {
+	uint16_t tenths = 0;
+	if (difficulty == 1) {
+		tenths = 900;
+	} else if (difficulty == 2) {
+		tenths = 450;
+	}
+	countdown_set(COUNTDOWN_P1, tenths);
+	countdown_set(COUNTDOWN_P2, tenths);
+}
+
+// Run the clock of the player whose turn it is in a timed game. The clocks
+// are stopped while the game is paused and once it is over.
+void run_turn_clock(void) {
+	bool running = difficulty > 0 && session_state == SESSION_PLAYING
+			&& !is_game_over();
+	bool player_1 = !two_player_game || move_player_1;
+	countdown_run(COUNTDOWN_P1, running && player_1);
+	countdown_run(COUNTDOWN_P2, running && !player_1);
+}
+
+// Carry out the action of each button push and of each character waiting
+// on the serial port (nothing at all if there's no input), and any command
+// from a test rig
+void handle_game_input(void) {
+	collect_game_input();
+	// An action can pause the game - anything after it waits in the queue
+	// until the game carries on
+	while (session_state == SESSION_PLAYING && action_count > 0) {
+		InputAction action = action_queue[action_head];
+		action_head = (action_head + 1) % ACTION_QUEUE_SIZE;
+		action_count--;
+		handle_action(action);
+	}
+
+	RemoteCommand command;
+	if (session_state == SESSION_PLAYING && remote_get_command(&command)) {
+		run_remote_command(&command, true);
+	}
+}
+
+// Add the actions of waiting button pushes and then of waiting characters
+// to action_queue, as far as there is room
+void collect_game_input(void) {
+	ButtonEvent button_event;
+	while (action_count < ACTION_QUEUE_SIZE && button_get_event(&button_event)) {
+		record_button_latency(button_event.time);
+		InputAction action = input_button_action(button_event.button);
+		if (action != ACTION_NONE) {
+			action_queue[(action_head + action_count++) % ACTION_QUEUE_SIZE] = action;
+		}
+	}
+	char pending_input[SERIAL_INPUT_BUFFER_SIZE];
+	uint8_t num_pending = serial_read_input(pending_input,
+			ACTION_QUEUE_SIZE - action_count);
+	num_pending = remote_filter_input(pending_input, num_pending);
+	for (uint8_t i = 0; i < num_pending; i++) {
+		InputAction action = input_key_action(pending_input[i]);
+		if (action != ACTION_NONE) {
+			action_queue[(action_head + action_count++) % ACTION_QUEUE_SIZE] = action;
 		}
+	}
+}
 
-		if (move_player_1) {
-			if (current_time >= p1_last_decrement_time + 100) {
-				p1_game_time -= 100;
-				p1_last_decrement_time = current_time;
-			}
-		} else {
-			if (current_time >= p2_last_decrement_time + 100) {
-				p2_game_time -= 100;
-				p2_last_decrement_time = current_time;
+// If there is a pause action in action_queue, remove it (leaving the others
+// in order) and return true
+bool take_queued_pause(void) {
+	for (uint8_t i = 0; i < action_count; i++) {
+		if (action_queue[(action_head + i) % ACTION_QUEUE_SIZE] == ACTION_PAUSE) {
+			for (uint8_t j = i + 1; j < action_count; j++) {
+				action_queue[(action_head + j - 1) % ACTION_QUEUE_SIZE] =
+						action_queue[(action_head + j) % ACTION_QUEUE_SIZE];
 			}
+			action_count--;
+			return true;
 		}
+	}
+	return false;
+}
 
-		// Hold player flash for 500ms after movement
-		if (player_moved) {
-			current_time = 0;
+// Keep track of the longest delay between a button being pushed and the
+// push being handled
+void record_button_latency(uint32_t push_time) {
+	uint32_t latency = get_current_time() - push_time;
+	if (latency > max_button_latency) {
+		max_button_latency = (latency > 0xFFFF) ? 0xFFFF : latency;
+	}
+}
+
+// Carry out an action from a key or button (see input.h) for the player
+// whose turn it is. Moves can't be made while the dice are rolling.
+void handle_action(InputAction action) {
+	bool player_1 = !two_player_game || move_player_1;
+	if (linked_game() && player_1 != link_is_player_1()) {
+		// The other unit's turn - it makes the moves
+		return;
+	}
+	if (action == ACTION_PAUSE) {
+		// A linked game can't be paused - the other unit would think
+		// the link had been lost
+		if (!linked_game()) {
+			game_pause();
 		}
-		if (current_time >= last_flash_time + 500) {
-			// 500ms (0.5 second) has passed since the last time we
-			// flashed the cursor, so flash the cursor
-			flash_player_cursor();
-			flash_player_2_cursor();
-			// Update the most recent time the cursor was flashed
-			last_flash_time = current_time;
+		return;
+	}
+
+	uint8_t link_action;
+	uint8_t link_value;
+	if (action == ACTION_ROLL) {
+		if (!start_roll) {
+			start_roll = true;
+			hud_set_P(HUD_STATUS, PSTR("Dice Rolling..."));
+			return;
 		}
+		start_roll = false;
+		hud_set_number_P(HUD_STATUS, PSTR("Dice Stopped. Value: "), dice_value);
+		take_turn(dice_value);
+		link_action = LINK_ACTION_ROLL;
+		link_value = dice_value;
+	} else if (start_roll) {
+		return;
+	} else if (action == ACTION_MOVE_1 || action == ACTION_MOVE_2) {
+		link_value = (action == ACTION_MOVE_1) ? 1 : 2;
+		take_turn(link_value);
+		link_action = LINK_ACTION_TURN;
+	} else if (action >= ACTION_UP && action <= ACTION_RIGHT) {
+		move_by_action(action, player_1);
+		player_moved = true;
+		link_action = LINK_ACTION_STEP;
+		link_value = action;
+	} else {
+		return;
+	}
 
-		player_moved = false;
+	// Send the move to the other unit of a linked game
+	if (linked_game()) {
+		uint8_t state[REMOTE_STATE_SIZE];
+		get_game_state(state, true);
+		link_send_turn(link_action, link_value, frame_crc16(state, REMOTE_STATE_SIZE));
+	}
+}
 
-		
-		if (difficulty > 0) {
-			move_terminal_cursor(10, 16);
-			if (move_player_1){
-				printf_P(PSTR("P1 time left: %d"), p1_game_time/1000);
-				if (p1_game_time < 10000) {
-					move_terminal_cursor(25, 16);
-					printf_P(PSTR(".%d"), (p1_game_time%1000)/100);
-				}
+// Move a player one square in the direction of ACTION_UP, ACTION_DOWN,
+// ACTION_LEFT or ACTION_RIGHT
+void move_by_action(InputAction direction, bool player_1) {
+	switch (direction) {
+		case ACTION_UP:
+			move_player(0, 1, player_1);
+			break;
+		case ACTION_DOWN:
+			move_player(0, -1, player_1);
+			break;
+		case ACTION_LEFT:
+			move_player(-1, 0, player_1);
+			break;
+		case ACTION_RIGHT:
+			move_player(1, 0, player_1);
+			break;
+		default:
+			return;
+	}
+	save_game();
+}
+
+// Move the player whose turn it is num_spaces forward (sliding down or
+// up any snake or ladder they land on) and count the move. In a two
+// player game it is then the other player's turn.
+void take_turn(uint8_t num_spaces) {
+	if (!two_player_game) {
+		move_player_n(num_spaces, true);
+		snake_ladder_func(true);
+		moves += 1;
+		run_turn_clock();
+		save_game();
+		return;
+	}
+	move_player_n(num_spaces, move_player_1);
+	snake_ladder_func(move_player_1);
+	if (move_player_1) {
+		player_1_moves += 1;
+		moves = player_1_moves;
+	} else {
+		player_2_moves += 1;
+		moves = player_2_moves;
+	}
+	move_player_1 = !move_player_1;
+	run_turn_clock();
+	save_game();
+}
+
+// Carry out a command from a test rig (see remote.h) and send the result.
+// Turns are only played if a game is in progress, and stop when the game
+// is over.
+void run_remote_command(const RemoteCommand* command, bool in_game) {
+	uint8_t turns_wanted = 0;
+	uint8_t turns = 0;
+	if (command->type == REMOTE_SEED && command->length == 2) {
+		srand(command->payload[0] | (command->payload[1] << 8));
+	} else if (command->type == REMOTE_ROLL && command->length == 1) {
+		turns_wanted = command->payload[0];
+	} else if (command->type == REMOTE_MOVE) {
+		turns_wanted = command->length;
+	} else if (command->type == REMOTE_BOARD_START && command->length == 2) {
+		remote_send_board_status(boards_upload_start(command->payload[0],
+				command->payload[1]));
+		return;
+	} else if (command->type == REMOTE_BOARD_DATA) {
+		remote_send_board_status(boards_upload_data(command->payload,
+				command->length));
+		return;
+	} else if (command->type == REMOTE_BOARD_FINISH && command->length == 2) {
+		remote_send_board_status(boards_upload_finish(command->payload[0]
+				| (command->payload[1] << 8)));
+		return;
+	} else if (command->type == REMOTE_BUDGET && command->length == 2) {
+		monitor_set_budget(command->payload[0] | (command->payload[1] << 8));
+	} else if (command->type == REMOTE_BIND) {
+		for (uint8_t i = 0; i + 1 < command->length; i += 2) {
+			uint8_t key = command->payload[i];
+			if (key & 0x80) {
+				input_bind_button(key & 0x7F, command->payload[i + 1]);
 			} else {
-				printf_P(PSTR("P2 time left: %d"), p2_game_time/1000);
-				if (p2_game_time < 10000) {
-					move_terminal_cursor(25, 16);
-					printf_P(PSTR(".%d"), (p2_game_time%1000)/100);
-				}
+				input_bind_key(key, command->payload[i + 1]);
 			}
 		}
-		snake_ladder_func(move_player_1);
-		// Shows previous player's no. of moves
-		seven_seg_display(moves, dice_value);
+	}
 
+	while (in_game && turns < turns_wanted && !is_game_over()) {
+		if (command->type == REMOTE_ROLL) {
+			dice_value = roll_dice();
+		} else if (command->payload[turns] >= 1 && command->payload[turns] <= 6) {
+			dice_value = command->payload[turns];
+		} else {
+			break;
+		}
+		take_turn(dice_value);
+		turns++;
 	}
-	// We get here if the game is over.
-	handle_game_over();
+	// Show where the tokens finished rather than every step
+	animation_skip();
+
+	uint8_t state[REMOTE_STATE_SIZE];
+	get_game_state(state, in_game);
+	remote_send_result(turns, state);
 }
 
-void game_pause(void) {
-	move_terminal_cursor(10, 12);
-	printf_P(PSTR("GAME PAUSED. Press 'p'/'P' to continue game"));
-	while (1) {
-		char serial_input = -1;
-		if (serial_input_available()){
-			serial_input = fgetc(stdin);
-		}
+// Fill in the state of the game (see remote.h) - used to check that a test
+// rig or the other unit of a linked game agrees on what has happened
+void get_game_state(uint8_t* state, bool in_game) {
+	int8_t x, y;
+	get_player_position(true, &x, &y);
+	state[REMOTE_P1_POSITION] = x | (y << 4);
+	state[REMOTE_P2_POSITION] = 0xFF;
+	state[REMOTE_P1_MOVES] = moves;
+	state[REMOTE_P2_MOVES] = 0;
+	state[REMOTE_TURN] = 0;
+	if (two_player_game) {
+		get_player_position(false, &x, &y);
+		state[REMOTE_P2_POSITION] = x | (y << 4);
+		state[REMOTE_P1_MOVES] = player_1_moves;
+		state[REMOTE_P2_MOVES] = player_2_moves;
+		state[REMOTE_TURN] = !move_player_1;
+	}
+	state[REMOTE_GAME_OVER] = in_game ? is_game_over() : 0;
+	state[REMOTE_DICE] = dice_value;
+}
 
-		if (serial_input == 'p' || serial_input == 'P') {
-			return;
-		}
-		seven_seg_display(moves, dice_value);
-		init_button_interrupts();
+// Save the game in EEPROM (see snapshot.h) so it can be carried on after a
+// reset. Linked games aren't saved - the other unit wouldn't carry on too.
+void save_game(void) {
+	if (linked_game()) {
+		return;
 	}
-	clear_to_end_of_line();
+	uint8_t snapshot[SNAPSHOT_SIZE];
+	int8_t x, y;
+
+	uint8_t flags = 0;
+	if (session_state != SESSION_GAME_OVER && !is_game_over()) {
+		flags |= SNAPSHOT_IN_PROGRESS;
+	}
+	if (two_player_game) {
+		flags |= SNAPSHOT_TWO_PLAYER;
+	}
+	if (!move_player_1) {
+		flags |= SNAPSHOT_P2_TURN;
+	}
+	snapshot[SNAPSHOT_FLAGS] = flags;
+	snapshot[SNAPSHOT_BOARD] = board_number;
+	snapshot[SNAPSHOT_DIFFICULTY] = difficulty;
+	get_player_position(true, &x, &y);
+	snapshot[SNAPSHOT_P1_POSITION] = x | (y << 4);
+	get_player_position(false, &x, &y);
+	snapshot[SNAPSHOT_P2_POSITION] = x | (y << 4);
+	snapshot[SNAPSHOT_P1_MOVES] = two_player_game ? player_1_moves : moves;
+	snapshot[SNAPSHOT_P2_MOVES] = player_2_moves;
+	uint16_t p1_time = countdown_tenths(COUNTDOWN_P1);
+	uint16_t p2_time = countdown_tenths(COUNTDOWN_P2);
+	snapshot[SNAPSHOT_P1_TIME] = p1_time & 0xFF;
+	snapshot[SNAPSHOT_P1_TIME + 1] = p1_time >> 8;
+	snapshot[SNAPSHOT_P2_TIME] = p2_time & 0xFF;
+	snapshot[SNAPSHOT_P2_TIME + 1] = p2_time >> 8;
+	snapshot[SNAPSHOT_DICE] = dice_value;
+	snapshot_save(snapshot);
 }
 
-void handle_game_over() {
-	clear_terminal();
-	move_terminal_cursor(10,14);
-	printf_P(PSTR("GAME OVER"));
-	move_terminal_cursor(10,15);
-	if (is_game_over() == 1 || p1_wins) {
-		printf_P(PSTR("Player 1 Wins!!"));
-	} else if (is_game_over() == 2 || p2_wins){
-		printf_P(PSTR("Player 2 Wins!!"));
-	} else {
-		printf_P(PSTR("No one wins :("));
+// Put the game back as it was when a snapshot was saved. Called after
+// new_game() has set up the board from the snapshot.
+void restore_game(const uint8_t* snapshot) {
+	uint8_t position = snapshot[SNAPSHOT_P1_POSITION];
+	set_player_position(true, position & 0x0F, position >> 4);
+	if (two_player_game) {
+		position = snapshot[SNAPSHOT_P2_POSITION];
+		set_player_position(false, position & 0x0F, position >> 4);
 	}
-	move_terminal_cursor(10,16);
-	printf_P(PSTR("Press a button or 's'/'S' to start again"));
-	
-	while(button_pushed() == NO_BUTTON_PUSHED && !serial_input_available()) {
-		; // wait
+	move_player_1 = !(snapshot[SNAPSHOT_FLAGS] & SNAPSHOT_P2_TURN);
+	player_1_moves = snapshot[SNAPSHOT_P1_MOVES];
+	player_2_moves = snapshot[SNAPSHOT_P2_MOVES];
+	// Moves shows the moves of the player who moved last
+	moves = (two_player_game && move_player_1) ? player_2_moves : player_1_moves;
+	dice_value = snapshot[SNAPSHOT_DICE];
+	if (difficulty > 0) {
+		countdown_set(COUNTDOWN_P1, snapshot[SNAPSHOT_P1_TIME]
+				| (snapshot[SNAPSHOT_P1_TIME + 1] << 8));
+		countdown_set(COUNTDOWN_P2, snapshot[SNAPSHOT_P2_TIME]
+				| (snapshot[SNAPSHOT_P2_TIME + 1] << 8));
 	}
 
-	char serial_input = -1;
-	if (serial_input_available()) {
-		serial_input = fgetc(stdin);
+	// Say when the game was ready again by the game clock, which only
+	// starts when timer 0 is set up (so not quite at the reset). The clock
+	// is clamped to fit the formatter, but won't be anywhere near that.
+	uint32_t uptime = get_current_time();
+	if (uptime > UINT16_MAX) {
+		uptime = UINT16_MAX;
 	}
-	// if the serial input is 's' or 'S', then exit the start screen
-	if ((serial_input == 's' || serial_input == 'S') || button_pushed()) {
-		main();
-	} else {
-		handle_game_over();
+	char text[HUD_MAX_WIDTH];
+	uint8_t length = format_string_P(text, 0, PSTR("Resumed after a reset at "));
+	length = format_uint(text, length, uptime, 1);
+	length = format_string_P(text, length, PSTR(" ms uptime"));
+	hud_set(HUD_MESSAGE, text, length);
+}
+
+bool linked_game(void) {
+	return link_state() != LINK_OFF && link_state() != LINK_INVITING;
+}
+
+// Pass bytes from the other unit to the link and let it send whatever it
+// needs to
+void service_link(uint32_t current_time) {
+	uint8_t received[UART1_BUFFER_SIZE];
+	uint8_t count = uart1_read(received, sizeof(received));
+	for (uint8_t i = 0; i < count; i++) {
+		link_receive(received[i], current_time);
 	}
-	
+	link_poll(current_time);
+}
+
+void link_transport_write(const uint8_t* data, uint8_t length) {
+	uart1_write(data, length);
 }
@@ -0,0 +1,77 @@
+/*
+ * pt.h
+ *
+ * Author: Arjun Srikanth
+ *
+ * Protothreads - stackless coroutines for flows which spend most of their
+ * time waiting (menus, the pause screen). A flow is a function which is
+ * called again and again from a loop; each call carries on from where the
+ * last one stopped waiting and returns as soon as it has to wait again.
+ * Only the point to carry on from is kept between calls (in a Protothread),
+ * so local variables are NOT kept - anything needed across a wait must be
+ * static or global. switch statements can't be used across a wait either,
+ * as the macros are built on one.
+ *
+ *	static char flow(Protothread* pt) {
+ *		PT_BEGIN(pt);
+ *		...
+ *		PT_WAIT_UNTIL(pt, key_pressed());
+ *		...
+ *		PT_END(pt);
+ *	}
+ *
+ *	Protothread pt;
+ *	PT_INIT(&pt);
+ *	while (PT_SCHEDULE(flow(&pt))) {
+ *		...
+ *	}
+ */
+
+
+#ifndef PT_H_
+#define PT_H_
+
+#include <stdint.h>
+
+typedef struct {
+	uint16_t line;	// where to carry on from (0 to start at the beginning)
+} Protothread;
+
+// Values returned by a flow
+#define PT_WAITING	0
+#define PT_ENDED	1
+
+// Start a flow again from the beginning
+#define PT_INIT(pt)	((pt)->line = 0)
+
+// Returns true if the flow (called as the argument) hasn't ended
+#define PT_SCHEDULE(call)	((call) == PT_WAITING)
+
+// Must start and end the body of every flow
+#define PT_BEGIN(pt)	switch ((pt)->line) { case 0:
+#define PT_END(pt)		} PT_INIT(pt); return PT_ENDED
+
+// Return until condition is true (it is checked again on every call)
+#define PT_WAIT_UNTIL(pt, condition) \
+	do { \
+		(pt)->line = __LINE__; case __LINE__: \
+		if (!(condition)) { \
+			return PT_WAITING; \
+		} \
+	} while (0)
+
+// Return once, carrying on from here on the next call
+#define PT_YIELD(pt) \
+	do { \
+		(pt)->line = __LINE__; \
+		return PT_WAITING; case __LINE__:; \
+	} while (0)
+
+// End the flow now
+#define PT_EXIT(pt) \
+	do { \
+		PT_INIT(pt); \
+		return PT_ENDED; \
+	} while (0)
+
+#endif /* PT_H_ */
@@ -0,0 +1,81 @@
+/*
+ * remote.c
+ *
+ * Author: Arjun Srikanth
+ */
+
+#include "remote.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include "frame.h"
+#include "serialio.h"
+
+static FrameParser parser;
+
+// The command waiting to be carried out (if command_waiting is true).
+// The rig waits for each result, so there is never more than one.
+static RemoteCommand command_received;
+static bool command_waiting;
+
+void remote_init(void) {
+	frame_parser_init(&parser);
+	command_waiting = false;
+}
+
+uint8_t remote_filter_input(char* input, uint8_t length) {
+	uint8_t kept = 0;
+	for (uint8_t i = 0; i < length; i++) {
+		uint8_t byte = input[i];
+		// A byte which arrives while the parser is looking for the start
+		// of a frame is a key, unless it starts a frame
+		bool is_key = (frame_parser_idle(&parser) && byte != FRAME_SYNC);
+		if (frame_parser_feed(&parser, byte)) {
+			command_received.type = parser.type;
+			command_received.length = parser.length;
+			for (uint8_t j = 0; j < parser.length; j++) {
+				command_received.payload[j] = parser.payload[j];
+			}
+			command_waiting = true;
+		} else if (is_key) {
+			input[kept++] = input[i];
+		}
+	}
+	return kept;
+}
+
+bool remote_get_command(RemoteCommand* command) {
+	if (!command_waiting) {
+		return false;
+	}
+	*command = command_received;
+	command_waiting = false;
+	return true;
+}
+
+// Send a reply frame, waiting for room for it if output is non-blocking so
+// the rig always gets a reply
+static void send_reply(uint8_t type, const uint8_t* payload, uint8_t length) {
+	uint8_t frame[FRAME_MAX_SIZE];
+	uint8_t size = frame_build(frame, type, payload, length);
+	while (serial_output_space() < size) {
+		; // wait
+	}
+	serial_write((const char*) frame, size);
+}
+
+void remote_send_result(uint8_t turns, const uint8_t* state) {
+	uint8_t payload[3 + REMOTE_STATE_SIZE];
+	uint16_t hash = frame_crc16(state, REMOTE_STATE_SIZE);
+	for (uint8_t i = 0; i < REMOTE_STATE_SIZE; i++) {
+		payload[3 + i] = state[i];
+	}
+	payload[0] = turns;
+	payload[1] = hash & 0xFF;
+	payload[2] = hash >> 8;
+
+	send_reply(REMOTE_RESULT, payload, sizeof(payload));
+}
+
+void remote_send_board_status(uint8_t status) {
+	send_reply(REMOTE_BOARD_STATUS, &status, 1);
+}
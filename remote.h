@@ -0,0 +1,83 @@
+/*
+ * remote.h
+ *
+ * Author: Arjun Srikanth
+ *
+ * Remote control of the game (and upload of boards) by a test rig over
+ * the serial port. The rig sends command frames (see frame.h) mixed in
+ * with ordinary key presses - frames start with a byte which is never a
+ * key, so keys still work. Each command is carried out as soon as it
+ * arrives and answered with a REMOTE_RESULT (or REMOTE_BOARD_STATUS)
+ * frame. The rig must wait for the reply before sending the next command.
+ *
+ * Turns in a batch are not animated and don't wait for the game loop, so
+ * thousands of turns a minute can be played. Dice are rolled with the
+ * avr-libc rand(), so a host model of the game can reproduce a run from
+ * its seed and check the state hash in each result.
+ */
+
+
+#ifndef REMOTE_H_
+#define REMOTE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "frame.h"
+
+// Command frame types (rig to game)
+#define REMOTE_SEED 0x10	// payload: seed for rand(), least significant byte first
+#define REMOTE_ROLL 0x11	// payload: number of turns to roll the dice for
+#define REMOTE_MOVE 0x12	// payload: spaces (1 to 6) to move on each turn
+#define REMOTE_BIND 0x13	// payload: pairs of key and action (see input.h). Keys
+							// from 0x80 are buttons (0x80 is B0).
+#define REMOTE_BOARD_START 0x14	// payload: slot, number of entries (see boards.h)
+#define REMOTE_BOARD_DATA 0x15	// payload: the next entries of the board
+#define REMOTE_BOARD_FINISH 0x16	// payload: CRC of the entries, least significant byte first
+#define REMOTE_BUDGET 0x17	// payload: game loop time budget in microseconds
+							// (see monitor.h), least significant byte first
+
+// Result frame type (game to rig). The payload is the number of turns
+// played, the state hash (least significant byte first) and the state.
+#define REMOTE_RESULT 0x20
+
+// Reply to each board upload command (game to rig). The payload is a
+// BoardStatus (see boards.h).
+#define REMOTE_BOARD_STATUS 0x21
+
+// The state after a command. The hash is the CRC-16 of these bytes (see
+// frame_crc16_update()).
+#define REMOTE_P1_POSITION 0	// x in bits 0-3, y in bits 4-7
+#define REMOTE_P2_POSITION 1	// 0xFF in one player games
+#define REMOTE_P1_MOVES 2
+#define REMOTE_P2_MOVES 3
+#define REMOTE_TURN 4			// 0 for player 1, 1 for player 2
+#define REMOTE_GAME_OVER 5		// see is_game_over()
+#define REMOTE_DICE 6
+#define REMOTE_STATE_SIZE 7
+
+typedef struct {
+	uint8_t type;
+	uint8_t length;
+	uint8_t payload[FRAME_MAX_PAYLOAD];
+} RemoteCommand;
+
+void remote_init(void);
+
+// Take any command frames out of the length characters of serial input
+// in input, leaving the other characters in order at the start of input.
+// Returns how many other characters there are.
+uint8_t remote_filter_input(char* input, uint8_t length);
+
+// Get the command which has arrived, if there is one. Returns false if
+// there isn't.
+bool remote_get_command(RemoteCommand* command);
+
+// Reply to a command with the number of turns played and the state
+// (REMOTE_STATE_SIZE bytes). Waits for room in the serial output buffer
+// so the rig always gets a reply.
+void remote_send_result(uint8_t turns, const uint8_t* state);
+
+// Reply to a board upload command
+void remote_send_board_status(uint8_t status);
+
+#endif /* REMOTE_H_ */
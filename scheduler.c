@@ -0,0 +1,106 @@
+/*
+ * scheduler.c
+ *
+ * Author: Arjun Srikanth
+ *
+ * With so few tasks a table is cheaper than a timer wheel or heap. The
+ * earliest time any task is due is kept so that scheduler_run() only has
+ * to make a single comparison when nothing is due, which is nearly every
+ * time around the game loop.
+ */
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+	TaskFunction function;	// 0 if the slot is free
+	uint16_t period;		// 0 for a task which runs once
+	uint32_t due_time;
+} Task;
+
+static Task tasks[SCHEDULER_MAX_TASKS];
+
+// Earliest due time of all the tasks
+static uint32_t next_due_time;
+
+// Times wrap around, so compare them by the difference between them
+static bool time_reached(uint32_t current_time, uint32_t time) {
+	return (int32_t)(current_time - time) >= 0;
+}
+
+static void find_next_due_time(void) {
+	bool found = false;
+	for (uint8_t i = 0; i < SCHEDULER_MAX_TASKS; i++) {
+		if (tasks[i].function && (!found
+				|| time_reached(next_due_time, tasks[i].due_time))) {
+			next_due_time = tasks[i].due_time;
+			found = true;
+		}
+	}
+	if (!found) {
+		// Nothing to run - check again in about 24 days
+		next_due_time += 0x7FFFFFFF;
+	}
+}
+
+void scheduler_init(void) {
+	for (uint8_t i = 0; i < SCHEDULER_MAX_TASKS; i++) {
+		tasks[i].function = 0;
+	}
+	find_next_due_time();
+}
+
+TaskId scheduler_add(TaskFunction function, uint16_t period,
+		uint32_t current_time) {
+	for (TaskId i = 0; i < SCHEDULER_MAX_TASKS; i++) {
+		if (!tasks[i].function) {
+			tasks[i].function = function;
+			tasks[i].period = period;
+			tasks[i].due_time = current_time + period;
+			find_next_due_time();
+			return i;
+		}
+	}
+	return SCHEDULER_NO_TASK;
+}
+
+void scheduler_remove(TaskId task) {
+	if (task < SCHEDULER_MAX_TASKS) {
+		tasks[task].function = 0;
+		find_next_due_time();
+	}
+}
+
+void scheduler_restart(TaskId task, uint32_t current_time) {
+	if (task < SCHEDULER_MAX_TASKS && tasks[task].function) {
+		tasks[task].due_time = current_time + tasks[task].period;
+		find_next_due_time();
+	}
+}
+
+void scheduler_delay(uint32_t delay) {
+	for (uint8_t i = 0; i < SCHEDULER_MAX_TASKS; i++) {
+		tasks[i].due_time += delay;
+	}
+	find_next_due_time();
+}
+
+void scheduler_run(uint32_t current_time) {
+	if (!time_reached(current_time, next_due_time)) {
+		return;
+	}
+	for (uint8_t i = 0; i < SCHEDULER_MAX_TASKS; i++) {
+		TaskFunction function = tasks[i].function;
+		if (!function || !time_reached(current_time, tasks[i].due_time)) {
+			continue;
+		}
+		if (tasks[i].period == 0) {
+			tasks[i].function = 0;
+		} else {
+			tasks[i].due_time += tasks[i].period;
+		}
+		function();
+	}
+	find_next_due_time();
+}
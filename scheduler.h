@@ -0,0 +1,63 @@
+/*
+ * scheduler.h
+ *
+ * Author: Arjun Srikanth
+ *
+ * Cooperative scheduler for work which has to be done regularly in the
+ * game loop (flashing the tokens and rolling the dice - the game clocks
+ * are counted down by the timer 0 interrupt instead, see countdown.h).
+ * Each task is a function which is run every period milliseconds.
+ * scheduler_run() should be called from the main loop with the current
+ * time (see timer0.h) and runs the tasks which are due - it does almost
+ * nothing when no task is due. Tasks run in the main loop, not in an
+ * interrupt, so they can do anything the loop can.
+ *
+ * A task's next run is worked out from when it was due rather than when
+ * it actually ran, so a task which runs late doesn't make the runs after
+ * it late as well. A task which is more than a period behind runs once
+ * each time scheduler_run() is called until it has caught up.
+ */
+
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Most tasks which can be added
+#define SCHEDULER_MAX_TASKS 8
+
+// Returned by scheduler_add() if there is no room for the task
+#define SCHEDULER_NO_TASK 0xFF
+
+typedef void (*TaskFunction)(void);
+typedef uint8_t TaskId;
+
+// Remove all tasks
+void scheduler_init(void);
+
+// Add a task which is run every period milliseconds, the first time period
+// milliseconds after current_time. A period of 0 runs the task once, at
+// current_time, and then removes it.
+TaskId scheduler_add(TaskFunction function, uint16_t period,
+		uint32_t current_time);
+
+// Remove a task (added with scheduler_add()). Nothing happens if the task
+// has already been removed.
+void scheduler_remove(TaskId task);
+
+// Start a task's period again, so it next runs a whole period after
+// current_time
+void scheduler_restart(TaskId task, uint32_t current_time);
+
+// Put back every task by the given number of milliseconds - used after the
+// game has been paused so tasks don't try to catch up with the time the
+// game was stopped for.
+void scheduler_delay(uint32_t delay);
+
+// Run the tasks which are due at current_time, in the order they were
+// added.
+void scheduler_run(uint32_t current_time);
+
+#endif /* SCHEDULER_H_ */
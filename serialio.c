@@ -11,7 +11,8 @@
  * output by the UART as speed permits.) If the buffer fills up, the
  * put method will either
  * (1) if interrupts are enabled, block until there is room in it, or
- * (2) if interrupts are disabled, will discard the character.
+ * (2) if interrupts are disabled, or non-blocking output has been
+ *     selected, will discard the character (and count it as dropped).
  * Input is blocking - requesting input from stdin will block
  * until a character is available. If interrupts are disabled when 
  * input is sought, then this will block forever.
@@ -25,35 +26,68 @@
 #include <stdint.h>
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include "memory.h"
 
 /* System clock rate in Hz. (L at the end indicates this is a long constant) */
 #define SYSCLK 8000000L
 
 /* Global variables */
-/* Circular buffer to hold outgoing characters. The insert_pos variable
- * keeps track of the position (0 to OUTPUT_BUFFER_SIZE-1) that the next
- * outgoing character should be written to. bytes_in_buffer keeps
- * count of the number of characters currently stored in the buffer 
- * (ranging from 0 to OUTPUT_BUFFER_SIZE). This number of bytes immediately
- * prior to the current insert_pos are the bytes waiting to be output.
- * If the insert_pos reaches the end of the buffer it will wrap around
- * to the beginning (assuming those bytes have been output).
- * NOTE - OUTPUT_BUFFER_SIZE can not be larger than 255 without changing
- * the type of the variables below (currently defined as 8 bit unsigned ints).
+/* Circular buffer to hold outgoing characters. The buffer size must be a
+ * power of two (no larger than 256) so that positions can be wrapped
+ * around with a mask. out_head is the position the next outgoing character
+ * will be written to and is only changed by the writing functions below.
+ * out_tail is the position of the next character to be sent and is only
+ * changed by the UART Data Register Empty interrupt handler. As each
+ * side only writes its own (single byte) position, no interrupts need to
+ * be disabled to add or remove characters. The buffer is empty when the
+ * positions are equal and full when out_head is one behind out_tail, so
+ * it holds up to OUTPUT_BUFFER_SIZE-1 characters.
  */
-#define OUTPUT_BUFFER_SIZE 255
+#ifndef OUTPUT_BUFFER_SIZE
+#define OUTPUT_BUFFER_SIZE 256
+#endif
+#define OUTPUT_BUFFER_MASK (OUTPUT_BUFFER_SIZE - 1)
+#if (OUTPUT_BUFFER_SIZE & OUTPUT_BUFFER_MASK) != 0 || OUTPUT_BUFFER_SIZE > 256
+#error "OUTPUT_BUFFER_SIZE must be a power of two no larger than 256"
+#endif
 volatile char out_buffer[OUTPUT_BUFFER_SIZE];
-volatile uint8_t out_insert_pos;
-volatile uint8_t bytes_in_out_buffer;
+volatile uint8_t out_head;
+volatile uint8_t out_tail;
+
+/* If non-zero, output functions never wait for space in the buffer -
+ * output which doesn't fit is discarded and counted in output_stats.
+ */
+static uint8_t out_nonblocking;
+static SerialOutputStats output_stats;
+
+/* Count of characters added to the output buffer (see
+ * serial_output_count())
+ */
+static uint16_t out_count;
 
 /* Circular buffer to hold incoming characters. Works on same principle
- * as output buffer
+ * as output buffer, except that the receive interrupt handler writes
+ * in_head and the main program moves in_tail. The size is set in
+ * serialio.h. We also keep count of the characters thrown away because
+ * the buffer was full and the most characters ever waiting at once.
  */
-#define INPUT_BUFFER_SIZE 16
+#define INPUT_BUFFER_SIZE SERIAL_INPUT_BUFFER_SIZE
+#define INPUT_BUFFER_MASK (INPUT_BUFFER_SIZE - 1)
+#if (INPUT_BUFFER_SIZE & INPUT_BUFFER_MASK) != 0 || INPUT_BUFFER_SIZE > 256
+#error "SERIAL_INPUT_BUFFER_SIZE must be a power of two no larger than 256"
+#endif
 volatile char input_buffer[INPUT_BUFFER_SIZE];
-volatile uint8_t input_insert_pos;
-volatile uint8_t bytes_in_input_buffer;
-volatile uint8_t input_overrun;
+volatile uint8_t in_head;
+volatile uint8_t in_tail;
+volatile uint16_t input_overruns;
+volatile uint8_t input_high_water;
+
+/* The baud rate the UART is actually running at, and its error from the
+ * requested rate in tenths of a percent.
+ */
+static long actual_baud;
+static int16_t baud_error;
 
 /* Variable to keep track of whether incoming characters are to be echoed
  * back or not.
@@ -72,29 +106,72 @@ static int uart_get_char(FILE*);
 static FILE myStream = FDEV_SETUP_STREAM(uart_put_char, uart_get_char,
 		_FDEV_SETUP_RW);
 
+/* Work out the UBRR value for the given baud rate when the UART divides
+ * the clock by divisor (16 normally, 8 in double speed mode), rounded to
+ * the nearest integer (using integer division, which truncates). The baud
+ * rate this gives is stored in actual.
+ */
+static uint16_t baud_setting(long baudrate, uint8_t divisor, long* actual) {
+	long ubrr = ((SYSCLK / (divisor / 2 * baudrate)) + 1)/2 - 1;
+	if(ubrr < 0) {
+		ubrr = 0;
+	} else if(ubrr > 4095) {
+		ubrr = 4095;
+	}
+	*actual = SYSCLK / (divisor * (ubrr + 1));
+	return ubrr;
+}
+
+/* Error of actual from baudrate in tenths of a percent */
+static int16_t error_tenths(long actual, long baudrate) {
+	return ((actual - baudrate) * 1000) / baudrate;
+}
+
 void init_serial_stdio(long baudrate, int8_t echo) {
 	uint16_t ubrr;
+	long normal_baud, double_baud;
 	/*
 	 * Initialise our buffers
 	*/
-	out_insert_pos = 0;
-	bytes_in_out_buffer = 0;
-	input_insert_pos = 0;
-	bytes_in_input_buffer = 0;
-	input_overrun = 0;
+	out_head = 0;
+	out_tail = 0;
+	out_nonblocking = 0;
+	output_stats.dropped_bytes = 0;
+	output_stats.dropped_writes = 0;
+	in_head = 0;
+	in_tail = 0;
+	memory_register(PSTR("serial port buffers"),
+			sizeof(out_buffer) + sizeof(input_buffer));
+	input_overruns = 0;
+	input_high_water = 0;
 	
 	/*
 	 * Record whether we're going to echo characters or not
 	*/
 	do_echo = echo;
 	
-	/* Configure the serial port baud rate */
-	/* (This differs from the datasheet formula so that we get 
-	 * rounding to the nearest integer while using integer division
-	 * (which truncates)).
+	/* Configure the serial port baud rate. Double speed mode (U2X)
+	 * divides the clock by 8 rather than 16, which allows higher baud
+	 * rates and finer steps between them, but the receiver takes fewer
+	 * samples of each bit. We use it only if it gets closer to the
+	 * requested baud rate than normal mode.
 	*/
-	ubrr = ((SYSCLK / (8 * baudrate)) + 1)/2 - 1;
-	UBRR0 = ubrr;
+	ubrr = baud_setting(baudrate, 16, &normal_baud);
+	uint16_t double_ubrr = baud_setting(baudrate, 8, &double_baud);
+	int16_t normal_error = error_tenths(normal_baud, baudrate);
+	int16_t double_error = error_tenths(double_baud, baudrate);
+	if((double_error < 0 ? -double_error : double_error) <
+			(normal_error < 0 ? -normal_error : normal_error)) {
+		UCSR0A |= (1<<U2X0);
+		UBRR0 = double_ubrr;
+		actual_baud = double_baud;
+		baud_error = double_error;
+	} else {
+		UCSR0A &= ~(1<<U2X0);
+		UBRR0 = ubrr;
+		actual_baud = normal_baud;
+		baud_error = normal_error;
+	}
 	
 	/*
 	 * Enable transmission and receiving via UART. We don't enable
@@ -118,98 +195,206 @@ void init_serial_stdio(long baudrate, int8_t echo) {
 	stdin = &myStream;
 }
 
+long serial_get_baud(void) {
+	return actual_baud;
+}
+
+int16_t serial_get_baud_error(void) {
+	return baud_error;
+}
+
 int8_t serial_input_available(void) {
-	return (bytes_in_input_buffer != 0);
+	return (in_head != in_tail);
 }
 
 void clear_serial_input_buffer(void) {
-	/* Just adjust our buffer data so it looks empty */
-	input_insert_pos = 0;
-	bytes_in_input_buffer = 0;
+	/* Just move our tail position up to the head so it looks empty */
+	in_tail = in_head;
 }
 
-static int uart_put_char(char c, FILE* stream) {
-	uint8_t interrupts_enabled;
+uint8_t serial_input_count(void) {
+	return (in_head - in_tail) & INPUT_BUFFER_MASK;
+}
+
+uint8_t serial_read_input(char* buf, uint8_t max) {
+	/* Take a copy of the head position - any characters arriving while
+	 * we're copying are left for next time. The tail is only updated
+	 * once at the end.
+	 */
+	uint8_t head = in_head;
+	uint8_t tail = in_tail;
+	uint8_t count = 0;
+	while(tail != head && count < max) {
+		buf[count++] = input_buffer[tail];
+		tail = (tail + 1) & INPUT_BUFFER_MASK;
+	}
+	in_tail = tail;
 	
-	/* Add the character to the buffer for transmission (if there 
-	 * is space to do so). If not we wait until the buffer has space.
-	 * If the character is \n, we output \r (carriage return)
+	if(do_echo) {
+		serial_write(buf, count);
+	}
+	return count;
+}
+
+void serial_get_input_stats(SerialInputStats* stats) {
+	/* The overrun count is two bytes, so make sure the interrupt handler
+	 * doesn't change it part way through reading it.
+	 */
+	uint8_t interrupts_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	stats->overruns = input_overruns;
+	stats->high_water = input_high_water;
+	if(interrupts_enabled) {
+		sei();
+	}
+}
+
+void serial_clear_input_stats(void) {
+	uint8_t interrupts_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	input_overruns = 0;
+	input_high_water = 0;
+	if(interrupts_enabled) {
+		sei();
+	}
+}
+
+/* Number of characters which can be added to the output buffer */
+static uint8_t output_space(void) {
+	return (out_tail - out_head - 1) & OUTPUT_BUFFER_MASK;
+}
+
+uint8_t serial_output_space(void) {
+	return output_space();
+}
+
+uint8_t serial_output_pending(void) {
+	return (out_head - out_tail) & OUTPUT_BUFFER_MASK;
+}
+
+uint16_t serial_output_count(void) {
+	return out_count;
+}
+
+void serial_set_output_nonblocking(uint8_t nonblocking) {
+	out_nonblocking = nonblocking;
+}
+
+void serial_get_output_stats(SerialOutputStats* stats) {
+	stats->dropped_bytes = output_stats.dropped_bytes;
+	stats->dropped_writes = output_stats.dropped_writes;
+}
+
+/* Wait until there is room for len characters in the output buffer.
+ * Returns 0 (without waiting) if we shouldn't wait - because we're in
+ * non-blocking mode or interrupts are disabled (the buffer will never be
+ * emptied if interrupts are disabled) - and there isn't enough room.
+ */
+static uint8_t wait_for_space(uint8_t len) {
+	if(output_space() >= len) {
+		return 1;
+	}
+	if(out_nonblocking || !bit_is_set(SREG, SREG_I)) {
+		return 0;
+	}
+	while(output_space() < len) {
+		/* do nothing - the interrupt handler will make room */
+	}
+	return 1;
+}
+
+/* Make sure the UART Data Register Empty interrupt is enabled so that
+ * it will fire and deal with the characters in the buffer. This is a
+ * read-modify-write of UCSR0B but needs no interrupt protection: the
+ * handler only ever clears UDRIE0 when the buffer is empty, and we have
+ * always added a character before setting it again - at worst the
+ * handler fires one extra time and finds nothing to send.
+ */
+static void start_output(void) {
+	UCSR0B |= (1 << UDRIE0);
+}
+
+uint16_t serial_write(const char* buf, uint16_t len) {
+	uint16_t written = 0;
+	while(written < len) {
+		/* Write as much as fits in the buffer at once (a chunk) */
+		uint16_t remaining = len - written;
+		uint8_t chunk = (remaining < OUTPUT_BUFFER_SIZE - 1) ?
+				remaining : OUTPUT_BUFFER_SIZE - 1;
+		if(!wait_for_space(chunk)) {
+			/* The rest of the write is discarded */
+			output_stats.dropped_bytes += remaining;
+			output_stats.dropped_writes++;
+			break;
+		}
+		uint8_t head = out_head;
+		for(uint8_t i = 0; i < chunk; i++) {
+			out_buffer[head] = buf[written + i];
+			head = (head + 1) & OUTPUT_BUFFER_MASK;
+		}
+		/* Only now can the interrupt handler see the new characters */
+		out_head = head;
+		start_output();
+		written += chunk;
+		out_count += chunk;
+	}
+	return written;
+}
+
+static int uart_put_char(char c, FILE* stream) {
+	/* If the character is \n, we output \r (carriage return)
 	 * also.
 	*/
 	if(c == '\n') {
 		uart_put_char('\r', stream);
 	}
 	
-	/* If the buffer is full and interrupts are disabled then we
-	 * abort - we don't output the character since the buffer will
-	 * never be emptied if interrupts are disabled. If the buffer is full
-	 * and interrupts are enabled then we loop until the buffer has 
-	 * enough space. The bytes_in_buffer variable will get modified by the
-	 * ISR which extracts bytes from the buffer.
+	/* If there is no space (and we can't wait for some) then we
+	 * discard the character.
 	*/
-	interrupts_enabled = bit_is_set(SREG, SREG_I);
-	while(bytes_in_out_buffer >= OUTPUT_BUFFER_SIZE) {
-		if(!interrupts_enabled) {
-			return 1;
-		}		
-		/* else do nothing */
+	if(!wait_for_space(1)) {
+		output_stats.dropped_bytes++;
+		output_stats.dropped_writes++;
+		return 1;
 	}
 	
-	/* Add the character to the buffer for transmission if there
-	 * is space to do so. We advance the insert_pos to the next
-	 * character position. If this is beyond the end of the buffer
-	 * we wrap around back to the beginning of the buffer 
-	 * NOTE: we disable interrupts before modifying the buffer. This
-	 * prevents the ISR from modifying the buffer at the same time.
-	 * We reenable them if they were enabled when we entered the
-	 * function.
-	*/	
-	cli();
-	out_buffer[out_insert_pos++] = c;
-	bytes_in_out_buffer++;
-	if(out_insert_pos == OUTPUT_BUFFER_SIZE) {
-		/* Wrap around buffer pointer if necessary */
-		out_insert_pos = 0;
-	}
-	/* Reenable interrupts (UDR Empty interrupt may have been
-	 * disabled) - we ensure it is now enabled so that it will
-	 * fire and deal with the next character in the buffer. */
-	UCSR0B |= (1 << UDRIE0);
-	if(interrupts_enabled) {
-		sei();
-	}
+	/* Add the character to the buffer and then advance the head
+	 * position so that the interrupt handler can see it.
+	*/
+	uint8_t head = out_head;
+	out_buffer[head] = c;
+	out_head = (head + 1) & OUTPUT_BUFFER_MASK;
+	start_output();
+	out_count++;
 	return 0;
 }
 
-int uart_get_char(FILE* stream) {
+static int uart_get_char(FILE* stream) {
 	/* Wait until we've received a character */
-	while(bytes_in_input_buffer == 0) {
+	while(in_head == in_tail) {
 		/* do nothing */
 	}
 	
 	/*
-	 * Turn interrupts off and remove a character from the input
-	 * buffer. We reenable interrupts if they were on.
-	 * The pending character is the one which is byte_in_input_buffer
-	 * characters before the insert position (taking into account
-	 * that we may need to wrap around).
+	 * Remove the character at the tail position from the input buffer.
+	 * The interrupt handler never changes in_tail, so there is no need
+	 * to turn interrupts off.
 	 */
-	uint8_t interrupts_enabled = bit_is_set(SREG, SREG_I);
-	cli();
-	char c;
-	if(input_insert_pos - bytes_in_input_buffer < 0) {
-		/* Need to wrap around */
-		c = input_buffer[input_insert_pos - bytes_in_input_buffer
-				+ INPUT_BUFFER_SIZE];
-	} else {
-		c = input_buffer[input_insert_pos - bytes_in_input_buffer];
+	uint8_t tail = in_tail;
+	char c = input_buffer[tail];
+	in_tail = (tail + 1) & INPUT_BUFFER_MASK;
+	
+	/* If the character is a carriage return, turn it into a
+	 * linefeed 
+	*/
+	if (c == '\r') {
+		c = '\n';
 	}
 	
-	/* Decrement our count of bytes in the input buffer */
-	bytes_in_input_buffer--;
-	if(interrupts_enabled) {
-		sei();
-	}	
+	if(do_echo) {
+		/* Echo the character back to the UART */
+		uart_put_char(c, stream);
+	}
 	return c;
 }
 
@@ -220,28 +405,13 @@ int uart_get_char(FILE* stream) {
 ISR(USART0_UDRE_vect) 
 {
 	/* Check if we have data in our buffer */
-	if(bytes_in_out_buffer > 0) {
-		/* Yes we do - remove the pending byte and output it
-		 * via the UART. The pending byte (character) is the
-		 * one which is "bytes_in_buffer" characters before the 
-		 * insert_pos (taking into account that we may 
-		 * need to wrap around to the end of the buffer).
-		 */
-		char c;
-		if(out_insert_pos - bytes_in_out_buffer < 0) {
-			/* Need to wrap around */
-			c = out_buffer[out_insert_pos - bytes_in_out_buffer
-				+ OUTPUT_BUFFER_SIZE];
-		} else {
-			c = out_buffer[out_insert_pos - bytes_in_out_buffer];
-		}
-		/* Decrement our count of the number of bytes in the 
-		 * buffer 
+	uint8_t tail = out_tail;
+	if(tail != out_head) {
+		/* Yes we do - output the next character via the UART and
+		 * advance the tail position past it.
 		 */
-		bytes_in_out_buffer--;
-		
-		/* Output the character via the UART */
-		UDR0 = c;
+		UDR0 = out_buffer[tail];
+		out_tail = (tail + 1) & OUTPUT_BUFFER_MASK;
 	} else {
 		/* No data in the buffer. We disable the UART Data
 		 * Register Empty interrupt because otherwise it 
@@ -261,43 +431,36 @@ ISR(USART0_UDRE_vect)
 
 ISR(USART0_RX_vect) 
 {
-	/* Read the character - we ignore the possibility of overrun. */
+	/* Read the character - we ignore the possibility of overrun. 
+	 * (Characters are echoed when they are read from the buffer, not
+	 * here, so that only the main program adds to the output buffer.)
+	 */
 	char c;
 	c = UDR0;
-		
-	if(do_echo && bytes_in_out_buffer < OUTPUT_BUFFER_SIZE) {
-		/* If echoing is enabled and there is output buffer
-		 * space, echo the received character back to the UART.
-		 * (If there is no output buffer space, characters
-		 * will be lost.)
-		 */
-		uart_put_char(c, 0);
-	}
 	
 	/* 
-	 * Check if we have space in our buffer. If not, set the overrun
-	 * flag and throw away the character. (We never clear the 
-	 * overrun flag - it's up to the programmer to check/clear
-	 * this flag if desired.)
+	 * Check if we have space in our buffer. If not, count the overrun
+	 * and throw away the character. (The count can be read and cleared
+	 * with serial_get_input_stats() and serial_clear_input_stats().)
 	 */
-	if(bytes_in_input_buffer >= INPUT_BUFFER_SIZE) {
-		input_overrun = 1;
-	} else {
-		/* If the character is a carriage return, turn it into a
-		 * linefeed 
-		*/
-		if (c == '\r') {
-			c = '\n';
+	uint8_t head = in_head;
+	uint8_t next_head = (head + 1) & INPUT_BUFFER_MASK;
+	if(next_head == in_tail) {
+		if(input_overruns != 0xFFFF) {
+			input_overruns++;
 		}
-		
+	} else {
 		/* 
-		 * There is room in the input buffer 
+		 * There is room in the input buffer. Characters are stored
+		 * as received (any conversion of carriage returns happens
+		 * when they are read through stdin).
 		 */
-		input_buffer[input_insert_pos++] = c;
-		bytes_in_input_buffer++;
-		if(input_insert_pos == INPUT_BUFFER_SIZE) {
-			/* Wrap around buffer pointer if necessary */
-			input_insert_pos = 0;
+		input_buffer[head] = c;
+		in_head = next_head;
+		
+		uint8_t count = (next_head - in_tail) & INPUT_BUFFER_MASK;
+		if(count > input_high_water) {
+			input_high_water = count;
 		}
 	}
 }
@@ -26,6 +26,23 @@
  */
 void init_serial_stdio(long baudrate, int8_t echo);
 
+/* Baud rate used by the game - 19200 unless the build defines another
+ * (e.g. -DSERIAL_BAUD=76800L), in which case the terminal and any host
+ * tools must be set to match. Rates which can be reached with little
+ * error from the 8MHz clock include 19200, 38400, 76800 (using double
+ * speed mode) and 250000.
+ */
+#ifndef SERIAL_BAUD
+#define SERIAL_BAUD 19200L
+#endif
+
+/* Return the baud rate the serial port is actually running at, and its
+ * error from the requested rate in tenths of a percent (e.g. 2 means the
+ * port is 0.2% fast). Errors beyond about 2% can cause garbled characters.
+ */
+long serial_get_baud(void);
+int16_t serial_get_baud_error(void);
+
 /* Test if input is available from the serial port. Return 0 if not,
  * non-zero otherwise. If there is input available then it can be read
  * with a suitable standard IO library function, e.g. fgetc().
@@ -37,5 +54,77 @@ int8_t serial_input_available(void);
  */
 void clear_serial_input_buffer(void);
 
+/* Size of the buffer holding received characters. Must be a power of two
+ * no larger than 256 - the buffer holds up to one less character than its
+ * size.
+ */
+#ifndef SERIAL_INPUT_BUFFER_SIZE
+#define SERIAL_INPUT_BUFFER_SIZE 32
+#endif
+
+/* Return the number of characters waiting to be read */
+uint8_t serial_input_count(void);
+
+/* Remove up to max waiting characters from the input buffer and copy them
+ * to buf, returning how many were copied. Unlike reading through stdin,
+ * characters are not changed (carriage returns are not turned into
+ * linefeeds). A buf of SERIAL_INPUT_BUFFER_SIZE characters is always big
+ * enough to take everything that is waiting.
+ */
+uint8_t serial_read_input(char* buf, uint8_t max);
+
+/* Statistics about the input buffer. overruns is the number of characters
+ * discarded because the buffer was full, and high_water the most
+ * characters that have been waiting at once.
+ */
+typedef struct {
+	uint16_t overruns;
+	uint8_t high_water;
+} SerialInputStats;
+
+void serial_get_input_stats(SerialInputStats* stats);
+void serial_clear_input_stats(void);
+
+/* Counts of output which has been discarded because the output buffer
+ * was full (see serial_set_output_nonblocking()).
+ */
+typedef struct {
+	uint16_t dropped_bytes;
+	uint16_t dropped_writes;
+} SerialOutputStats;
+
+/* Write len characters to the serial port (no conversion of \n to \r\n
+ * is done). The characters are copied into the output buffer as large
+ * chunks. Returns the number of characters written - this is less than
+ * len only if output was discarded. In non-blocking mode each chunk is
+ * either written in full or discarded, so a write of no more than
+ * serial_output_space() characters is never cut off part way.
+ */
+uint16_t serial_write(const char* buf, uint16_t len);
+
+/* Return the number of characters which can currently be written without
+ * waiting.
+ */
+uint8_t serial_output_space(void);
+
+/* Return the number of characters waiting to be sent */
+uint8_t serial_output_pending(void);
+
+/* Return a count (which wraps around) of the characters added to the
+ * output buffer. Code which keeps track of where the terminal cursor is
+ * can compare it with the count after its own output to tell whether
+ * anything else has been written since.
+ */
+uint16_t serial_output_count(void);
+
+/* Select whether output waits for room in the output buffer (zero, the
+ * default) or is discarded when the buffer is full (non-zero). Non-blocking
+ * output means a slow terminal can never hold up the caller.
+ */
+void serial_set_output_nonblocking(uint8_t nonblocking);
+
+/* Get the counts of discarded output */
+void serial_get_output_stats(SerialOutputStats* stats);
+
 
 #endif /* SERIALIO_H_ */
\ No newline at end of file
@@ -0,0 +1,130 @@
+/*
+ * snapshot.c
+ *
+ * Author: Arjun Srikanth
+ *
+ * Each slot holds a sequence number, the snapshot and a CRC-8 (see
+ * frame.h) of both. Snapshots are written with sequence numbers one more
+ * than the last, so the newest snapshot is in the valid slot whose next
+ * slot doesn't hold the next sequence number.
+ */
+
+#include "snapshot.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "boards.h"
+#include "frame.h"
+#include "storage.h"
+
+// The slots follow the stored boards in EEPROM
+#define SLOT_SIZE (SNAPSHOT_SIZE + 2)
+#define SLOT_ADDRESS(slot) (BOARDS_EEPROM_SIZE + (uint16_t) (slot) * SLOT_SIZE)
+
+// Slot being written, the bytes to write into it and how many have been
+// written (SLOT_SIZE once it has all been written)
+static uint8_t write_slot;
+static uint8_t write_buffer[SLOT_SIZE];
+static volatile uint8_t write_index = SLOT_SIZE;
+
+// Sequence number of the last snapshot written
+static uint8_t sequence;
+
+// Snapshot to write when the current one is finished
+static uint8_t waiting[SNAPSHOT_SIZE];
+static volatile bool snapshot_waiting;
+
+static uint8_t slot_crc(const uint8_t* slot) {
+	uint8_t crc = 0;
+	for (uint8_t i = 0; i < SLOT_SIZE - 1; i++) {
+		crc = frame_crc_update(crc, slot[i]);
+	}
+	return crc;
+}
+
+// Start writing a snapshot into the next slot. Called with the EEPROM
+// ready interrupt off.
+static void start_write(const uint8_t* snapshot) {
+	write_slot = (write_slot + 1) % SNAPSHOT_SLOTS;
+	write_buffer[0] = ++sequence;
+	for (uint8_t i = 0; i < SNAPSHOT_SIZE; i++) {
+		write_buffer[i + 1] = snapshot[i];
+	}
+	write_buffer[SLOT_SIZE - 1] = slot_crc(write_buffer);
+	write_index = 0;
+	EECR |= (1<<EERIE);
+}
+
+void snapshot_save(const uint8_t* snapshot) {
+	// Keep the interrupt handler away while the waiting snapshot changes
+	EECR &= ~(1<<EERIE);
+	if (write_index == SLOT_SIZE && !snapshot_waiting) {
+		start_write(snapshot);
+		return;
+	}
+	// Replace the waiting snapshot - even if the last write has just
+	// finished, it must not be written after this newer one
+	for (uint8_t i = 0; i < SNAPSHOT_SIZE; i++) {
+		waiting[i] = snapshot[i];
+	}
+	snapshot_waiting = true;
+	EECR |= (1<<EERIE);
+}
+
+// Read a slot into buffer - returns true if it holds a snapshot
+static bool read_slot(uint8_t slot, uint8_t* buffer) {
+	storage_read_block(buffer, SLOT_ADDRESS(slot), SLOT_SIZE);
+	return slot_crc(buffer) == buffer[SLOT_SIZE - 1];
+}
+
+bool snapshot_load(uint8_t* snapshot) {
+	snapshot_wait();
+	uint8_t slot_data[SLOT_SIZE];
+	uint8_t next_data[SLOT_SIZE];
+	bool next_valid = read_slot(0, next_data);
+	for (uint8_t slot = 0; slot < SNAPSHOT_SLOTS; slot++) {
+		bool valid = next_valid;
+		for (uint8_t i = 0; i < SLOT_SIZE; i++) {
+			slot_data[i] = next_data[i];
+		}
+		next_valid = read_slot((slot + 1) % SNAPSHOT_SLOTS, next_data);
+		if (valid && (!next_valid || next_data[0] != (uint8_t) (slot_data[0] + 1))) {
+			// Newest - carry on after it
+			write_slot = slot;
+			sequence = slot_data[0];
+			for (uint8_t i = 0; i < SNAPSHOT_SIZE; i++) {
+				snapshot[i] = slot_data[i + 1];
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+void snapshot_wait(void) {
+	while (write_index != SLOT_SIZE || snapshot_waiting) {
+		; // wait
+	}
+}
+
+// Write the next byte each time the EEPROM is ready. Bytes which already
+// hold the right value aren't written, to save wear and time.
+ISR(EE_READY_vect) {
+	if (write_index == SLOT_SIZE) {
+		if (!snapshot_waiting) {
+			EECR &= ~(1<<EERIE);
+			return;
+		}
+		snapshot_waiting = false;
+		start_write(waiting);
+	}
+	EEAR = SLOT_ADDRESS(write_slot) + write_index;
+	uint8_t value = write_buffer[write_index++];
+	EECR |= (1<<EERE);
+	if (EEDR != value) {
+		EEDR = value;
+		EECR |= (1<<EEMPE);
+		EECR |= (1<<EEPE);
+	}
+}
@@ -0,0 +1,57 @@
+/*
+ * snapshot.h
+ *
+ * Author: Arjun Srikanth
+ *
+ * A snapshot of the game saved in EEPROM after every turn, so a game can
+ * carry on where it left off after a power cut or reset. Snapshots are
+ * written to SNAPSHOT_SLOTS slots in turn, so each slot is only written
+ * once every SNAPSHOT_SLOTS turns, and the slot being written never holds
+ * the newest complete snapshot - a write which is cut off just leaves the
+ * one before it as the newest.
+ *
+ * Writing EEPROM takes about 3.4ms a byte, so snapshots are written a
+ * byte at a time by the EEPROM ready interrupt and saving one never waits.
+ */
+
+
+#ifndef SNAPSHOT_H_
+#define SNAPSHOT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Bytes of a snapshot
+#define SNAPSHOT_FLAGS 0
+#define SNAPSHOT_BOARD 1			// board number
+#define SNAPSHOT_DIFFICULTY 2
+#define SNAPSHOT_P1_POSITION 3		// x in bits 0-3, y in bits 4-7
+#define SNAPSHOT_P2_POSITION 4
+#define SNAPSHOT_P1_MOVES 5			// moves in a one player game
+#define SNAPSHOT_P2_MOVES 6
+#define SNAPSHOT_P1_TIME 7			// tenths of a second, 2 bytes, least
+#define SNAPSHOT_P2_TIME 9			// significant byte first
+#define SNAPSHOT_DICE 11
+#define SNAPSHOT_SIZE 12
+
+// Flags
+#define SNAPSHOT_IN_PROGRESS 0x01	// the game isn't over yet
+#define SNAPSHOT_TWO_PLAYER 0x02
+#define SNAPSHOT_P2_TURN 0x04
+
+#define SNAPSHOT_SLOTS 32
+
+// Save a snapshot. If a snapshot is still being written, this one is
+// written straight after it (replacing any other waiting to be written).
+void snapshot_save(const uint8_t* snapshot);
+
+// Copy the newest snapshot into snapshot. Returns false if there isn't a
+// snapshot (or none could be read). Must be called at start up, before any
+// snapshot is saved, so new snapshots carry on after the newest one.
+bool snapshot_load(uint8_t* snapshot);
+
+// Wait until every snapshot has been written. Other EEPROM access doesn't
+// need to wait (see storage.h).
+void snapshot_wait(void);
+
+#endif /* SNAPSHOT_H_ */
@@ -0,0 +1,66 @@
+/*
+ * storage.c
+ *
+ * Author: Arjun Srikanth
+ *
+ * The avr-libc EEPROM functions wait for any write in progress (including
+ * one started by the interrupt handler) before using the registers, so
+ * only the interrupt itself needs to be kept away.
+ */
+
+#include "storage.h"
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/eeprom.h>
+
+// Turn off the EEPROM ready interrupt, returning its enable bit so it can
+// be put back afterwards. If the handler finishes between reading and
+// clearing the bit, putting it back just runs the handler once more with
+// nothing to write, which turns it off again.
+static uint8_t hold_writer(void) {
+	uint8_t enabled = EECR & (1<<EERIE);
+	EECR &= ~(1<<EERIE);
+	return enabled;
+}
+
+static void release_writer(uint8_t enabled) {
+	EECR |= enabled;
+}
+
+uint8_t storage_read_byte(uint16_t address) {
+	uint8_t enabled = hold_writer();
+	uint8_t value = eeprom_read_byte((const uint8_t*) address);
+	release_writer(enabled);
+	return value;
+}
+
+uint16_t storage_read_word(uint16_t address) {
+	uint8_t enabled = hold_writer();
+	uint16_t value = eeprom_read_word((const uint16_t*) address);
+	release_writer(enabled);
+	return value;
+}
+
+void storage_read_block(void* data, uint16_t address, uint8_t length) {
+	uint8_t enabled = hold_writer();
+	eeprom_read_block(data, (const void*) address, length);
+	release_writer(enabled);
+}
+
+void storage_update_byte(uint16_t address, uint8_t value) {
+	uint8_t enabled = hold_writer();
+	eeprom_update_byte((uint8_t*) address, value);
+	release_writer(enabled);
+}
+
+void storage_update_word(uint16_t address, uint16_t value) {
+	uint8_t enabled = hold_writer();
+	eeprom_update_word((uint16_t*) address, value);
+	release_writer(enabled);
+}
+
+void storage_update_block(const void* data, uint16_t address, uint8_t length) {
+	uint8_t enabled = hold_writer();
+	eeprom_update_block(data, (void*) address, length);
+	release_writer(enabled);
+}
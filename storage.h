@@ -0,0 +1,28 @@
+/*
+ * storage.h
+ *
+ * Author: Arjun Srikanth
+ *
+ * All EEPROM access from the main program goes through here. Game
+ * snapshots (see snapshot.h) are written in the background by the EEPROM
+ * ready interrupt, which uses the same EEPROM registers, so it is held off
+ * while each read or write here is made. A background write is never
+ * disturbed, and carries on as soon as the access has been made.
+ */
+
+
+#ifndef STORAGE_H_
+#define STORAGE_H_
+
+#include <stdint.h>
+
+uint8_t storage_read_byte(uint16_t address);
+uint16_t storage_read_word(uint16_t address);
+void storage_read_block(void* data, uint16_t address, uint8_t length);
+
+// Only bytes which change are written, to save wear and time
+void storage_update_byte(uint16_t address, uint8_t value);
+void storage_update_word(uint16_t address, uint16_t value);
+void storage_update_block(const void* data, uint16_t address, uint8_t length);
+
+#endif /* STORAGE_H_ */
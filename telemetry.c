@@ -0,0 +1,100 @@
+/*
+ * telemetry.c
+ *
+ * Author: Arjun Srikanth
+ */
+
+#include "telemetry.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include "frame.h"
+#include "serialio.h"
+
+static bool telemetry_on;
+
+// The latest state, and the state the receiver has been sent
+static uint8_t state[TELEMETRY_STATE_SIZE];
+static uint8_t sent_state[TELEMETRY_STATE_SIZE];
+
+static bool snapshot_needed;
+static uint32_t last_frame_time;
+static uint32_t last_snapshot_time;
+
+void telemetry_set_enabled(bool enabled) {
+	telemetry_on = enabled;
+}
+
+bool telemetry_enabled(void) {
+	return telemetry_on;
+}
+
+void telemetry_start(void) {
+	snapshot_needed = true;
+}
+
+// Send a frame in one piece. Returns true if it was sent (it isn't if
+// there's no room for all of it in the serial output buffer).
+static bool send_frame(uint8_t type, const uint8_t* payload, uint8_t length) {
+	uint8_t frame[FRAME_MAX_SIZE];
+	uint8_t size = frame_build(frame, type, payload, length);
+	return serial_write((const char*) frame, size) == size;
+}
+
+static void send_snapshot(uint32_t current_time) {
+	if (send_frame(TELEMETRY_SNAPSHOT, state, TELEMETRY_STATE_SIZE)) {
+		for (uint8_t i = 0; i < TELEMETRY_STATE_SIZE; i++) {
+			sent_state[i] = state[i];
+		}
+		snapshot_needed = false;
+		last_snapshot_time = current_time;
+	}
+}
+
+// Send the fields which differ from what the receiver has
+static void send_delta(void) {
+	uint8_t payload[1 + TELEMETRY_STATE_SIZE];
+	uint8_t length = 1;
+	payload[0] = 0;
+	for (uint8_t field = 0; field < TELEMETRY_NUM_FIELDS; field++) {
+		uint8_t offset = TELEMETRY_FIELD_OFFSET(field);
+		uint8_t size = TELEMETRY_FIELD_SIZE(field);
+		bool changed = false;
+		for (uint8_t i = offset; i < offset + size; i++) {
+			changed |= (state[i] != sent_state[i]);
+		}
+		if (changed) {
+			payload[0] |= (1 << field);
+			for (uint8_t i = offset; i < offset + size; i++) {
+				payload[length++] = state[i];
+			}
+		}
+	}
+	if (payload[0] && send_frame(TELEMETRY_DELTA, payload, length)) {
+		for (uint8_t i = 0; i < TELEMETRY_STATE_SIZE; i++) {
+			sent_state[i] = state[i];
+		}
+	}
+}
+
+void telemetry_update(const uint8_t* new_state, uint32_t current_time) {
+	for (uint8_t i = 0; i < TELEMETRY_STATE_SIZE; i++) {
+		state[i] = new_state[i];
+	}
+	if (!telemetry_on || current_time - last_frame_time < TELEMETRY_INTERVAL_MS) {
+		return;
+	}
+	last_frame_time = current_time;
+	if (snapshot_needed || current_time - last_snapshot_time >= TELEMETRY_SNAPSHOT_MS) {
+		send_snapshot(current_time);
+	} else {
+		send_delta();
+	}
+}
+
+void telemetry_send_final(uint8_t flags) {
+	if (!telemetry_on) {
+		return;
+	}
+	state[TELEMETRY_FLAGS] |= flags;
+	send_frame(TELEMETRY_SNAPSHOT, state, TELEMETRY_STATE_SIZE);
+}
@@ -0,0 +1,79 @@
+/*
+ * telemetry.h
+ *
+ * Author: Arjun Srikanth
+ *
+ * Optional machine readable game state, sent over the serial port as
+ * frames (see frame.h) in place of the terminal board mirror and HUD.
+ * Telemetry is turned on and off from the start screen.
+ *
+ * The state is TELEMETRY_STATE_SIZE bytes made up of the fields below. A
+ * snapshot frame carries the whole state. A delta frame carries a byte
+ * with bit n set if field n has changed, followed by the new value of
+ * each changed field in order. Deltas are only sent for changes, at most
+ * once every TELEMETRY_INTERVAL_MS, and a snapshot is sent at the start
+ * of a game and every TELEMETRY_SNAPSHOT_MS so a receiver which starts
+ * listening part way through a game (or misses a frame) catches up.
+ *
+ * The definitions here are shared with the host decoder (see host/).
+ */
+
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Frame types
+#define TELEMETRY_SNAPSHOT 0x01
+#define TELEMETRY_DELTA 0x02
+
+// Fields of the state, in order. Each is one byte apart from the times
+// (tenths of a second left, least significant byte first).
+#define TELEMETRY_FLAGS 0
+#define TELEMETRY_P1_POSITION 1	// x in bits 0-3, y in bits 4-7
+#define TELEMETRY_P2_POSITION 2	// TELEMETRY_NO_PLAYER in one player games
+#define TELEMETRY_DICE 3
+#define TELEMETRY_MOVES 4
+#define TELEMETRY_P1_TIME 5
+#define TELEMETRY_P2_TIME 6
+#define TELEMETRY_NUM_FIELDS 7
+#define TELEMETRY_STATE_SIZE 9
+
+// Where a field starts in the state and how many bytes it has
+#define TELEMETRY_FIELD_OFFSET(field) \
+		((field) <= TELEMETRY_P1_TIME ? (field) : (field) * 2 - TELEMETRY_P1_TIME)
+#define TELEMETRY_FIELD_SIZE(field) ((field) < TELEMETRY_P1_TIME ? 1 : 2)
+
+// Bits of the flags field
+#define TELEMETRY_TWO_PLAYER (1 << 0)
+#define TELEMETRY_P2_TURN (1 << 1)
+#define TELEMETRY_ROLLING (1 << 2)
+#define TELEMETRY_TIMED (1 << 3)
+#define TELEMETRY_GAME_OVER (1 << 4)
+#define TELEMETRY_P1_WINS (1 << 5)
+#define TELEMETRY_P2_WINS (1 << 6)
+
+#define TELEMETRY_NO_PLAYER 0xFF
+
+#define TELEMETRY_INTERVAL_MS 50
+#define TELEMETRY_SNAPSHOT_MS 5000
+
+void telemetry_set_enabled(bool enabled);
+bool telemetry_enabled(void);
+
+// Called at the start of a game - the next frame sent is a snapshot
+void telemetry_start(void);
+
+// Set the current state. Whatever has changed is sent if it is time to
+// send a frame. If there isn't room for a frame in the serial output
+// buffer it is sent later instead.
+void telemetry_update(const uint8_t* state, uint32_t current_time);
+
+// Send a snapshot of the last state set with the given flags added (e.g.
+// TELEMETRY_GAME_OVER). Serial output should be blocking so the frame
+// isn't lost.
+void telemetry_send_final(uint8_t flags);
+
+#endif /* TELEMETRY_H_ */
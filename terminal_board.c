@@ -0,0 +1,172 @@
+/*
+ * terminal_board.c
+ *
+ * Author: Arjun Srikanth
+ *
+ * Cursor position and background colour are remembered between squares
+ * drawn in the same frame so that consecutive squares on a row need no
+ * cursor movement or colour change. Other output can happen between
+ * frames, so nothing is assumed about the terminal at the start of a frame.
+ * A square is only drawn if there is room for it in the serial output
+ * buffer, so a square is never left half drawn when output is discarded
+ * (see serial_set_output_nonblocking()).
+ */
+
+#include "terminal_board.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "terminalio.h"
+#include "serialio.h"
+#include "display.h"
+#include "game.h"
+
+static bool mirror_enabled;
+
+// Terminal cursor position after the last square drawn in this frame
+// (only valid if cursor_known is true), and the background colour
+// currently set (TERM_RESET if it hasn't been set this frame).
+static bool cursor_known;
+static uint8_t cursor_col;
+static uint8_t cursor_row;
+static DisplayParameter current_background = TERM_RESET;
+
+// Most characters needed to draw one square (cursor movement, colour
+// change and the square itself), and to restore the display attributes
+#define SQUARE_OUTPUT_SIZE (2 * TERMINAL_MAX_SEQUENCE + 2)
+#define RESET_OUTPUT_SIZE 4
+
+// Squares which couldn't be drawn because the serial output buffer was
+// full (one byte per row, one bit per column). They are drawn as soon as
+// there is room.
+static uint8_t pending_squares[HEIGHT];
+
+// Work out how a square of the given LED matrix colour is drawn - the
+// background colour is returned and the two characters are put in text.
+static DisplayParameter square_style(PixelColour colour, char text[2]) {
+	text[0] = ' ';
+	text[1] = ' ';
+	switch (colour) {
+		case MATRIX_COLOUR_EMPTY:
+			return BG_BLACK;
+		case MATRIX_COLOUR_START_END:
+			return BG_WHITE;
+		case MATRIX_COLOUR_P1:
+			text[0] = 'P';
+			text[1] = '1';
+			return BG_MAGENTA;
+		case MATRIX_COLOUR_P2:
+			text[0] = 'P';
+			text[1] = '2';
+			return BG_CYAN;
+		case MATRIX_COLOUR_SNAKE:
+			return BG_RED;
+		case MATRIX_COLOUR_LADDER:
+			return BG_GREEN;
+		// Anything else is an overlay
+		default:
+			return BG_BLUE;
+	}
+}
+
+// Append the escape sequence to move the cursor to (col, row) using as
+// few characters as possible. Moving forward along the same row only
+// needs a cursor forward sequence.
+static uint8_t format_move_to(char* buf, uint8_t pos, uint8_t col, uint8_t row) {
+	if (cursor_known && row == cursor_row && col == cursor_col) {
+		return pos;
+	}
+	if (cursor_known && row == cursor_row && col > cursor_col) {
+		return terminal_format_cursor_forward(buf, pos, col - cursor_col);
+	}
+	return terminal_format_cursor_move(buf, pos, col, row);
+}
+
+void terminal_board_init(void) {
+	// Border around the board
+	draw_horizontal_line(TERMINAL_BOARD_Y - 1, TERMINAL_BOARD_X - 1,
+			TERMINAL_BOARD_X + 2 * WIDTH);
+	draw_horizontal_line(TERMINAL_BOARD_Y + HEIGHT, TERMINAL_BOARD_X - 1,
+			TERMINAL_BOARD_X + 2 * WIDTH);
+	draw_vertical_line(TERMINAL_BOARD_X - 1, TERMINAL_BOARD_Y,
+			TERMINAL_BOARD_Y + HEIGHT - 1);
+	draw_vertical_line(TERMINAL_BOARD_X + 2 * WIDTH, TERMINAL_BOARD_Y,
+			TERMINAL_BOARD_Y + HEIGHT - 1);
+
+	// Empty squares - anything else is drawn when the display is rendered
+	set_display_attribute(BG_BLACK);
+	for (uint8_t row = 0; row < HEIGHT; row++) {
+		move_terminal_cursor(TERMINAL_BOARD_X, TERMINAL_BOARD_Y + row);
+		for (uint8_t x = 0; x < 2 * WIDTH; x++) {
+			putchar(' ');
+		}
+	}
+	normal_display_mode();
+
+	cursor_known = false;
+	current_background = TERM_RESET;
+	for (uint8_t y = 0; y < HEIGHT; y++) {
+		pending_squares[y] = 0;
+	}
+	mirror_enabled = true;
+}
+
+void terminal_board_disable(void) {
+	mirror_enabled = false;
+}
+
+bool terminal_board_enabled(void) {
+	return mirror_enabled;
+}
+
+void terminal_board_update(uint8_t x, uint8_t y, PixelColour colour) {
+	if (!mirror_enabled) {
+		return;
+	}
+
+	// Build everything needed to draw the square. Row HEIGHT - 1 of the
+	// board is at the top of the terminal.
+	char buf[SQUARE_OUTPUT_SIZE];
+	char text[2];
+	DisplayParameter background = square_style(colour, text);
+	uint8_t col = TERMINAL_BOARD_X + 2 * x;
+	uint8_t row = TERMINAL_BOARD_Y + (HEIGHT - 1 - y);
+	uint8_t len = format_move_to(buf, 0, col, row);
+	if (background != current_background) {
+		len = terminal_format_attribute(buf, len, background);
+	}
+	buf[len++] = text[0];
+	buf[len++] = text[1];
+
+	// Don't let the output be cut off - if there isn't room for the
+	// square (and restoring the display attributes afterwards), draw it
+	// later instead
+	if (serial_output_space() < len + RESET_OUTPUT_SIZE) {
+		pending_squares[y] |= (1 << x);
+		return;
+	}
+	pending_squares[y] &= ~(1 << x);
+	serial_write(buf, len);
+
+	cursor_known = true;
+	cursor_col = col + 2;
+	cursor_row = row;
+	current_background = background;
+}
+
+void terminal_board_end_frame(void) {
+	// Retry any squares which couldn't be drawn before
+	for (uint8_t y = 0; y < HEIGHT && mirror_enabled; y++) {
+		for (uint8_t x = 0; x < WIDTH && pending_squares[y]; x++) {
+			if (pending_squares[y] & (1 << x)) {
+				terminal_board_update(x, y, display_get_colour(x, y));
+			}
+		}
+	}
+
+	if (current_background != TERM_RESET) {
+		normal_display_mode();
+		current_background = TERM_RESET;
+	}
+	cursor_known = false;
+}
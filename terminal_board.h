@@ -0,0 +1,44 @@
+/*
+ * terminal_board.h
+ *
+ * Author: Arjun Srikanth
+ *
+ * Mirror of the LED matrix board on the serial terminal. Each square is
+ * drawn as two characters with a background colour matching the LED
+ * matrix colour. After terminal_board_init() has drawn the whole board,
+ * only squares whose colour changes are sent (see display_render() in
+ * display.c), using the shortest cursor movement from the last square
+ * drawn.
+ */
+
+
+#ifndef TERMINAL_BOARD_H_
+#define TERMINAL_BOARD_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pixel_colour.h"
+
+// Terminal position (column, row) of the top left square of the board.
+// The board takes up two columns per square and has a border around it.
+#define TERMINAL_BOARD_X 60
+#define TERMINAL_BOARD_Y 3
+
+// Draw the border and an empty board, and start mirroring changes.
+// The terminal should have been cleared first.
+void terminal_board_init(void);
+
+// Stop mirroring changes (e.g. when the terminal is showing something else)
+void terminal_board_disable(void);
+
+// Returns true if changes are being mirrored.
+bool terminal_board_enabled(void);
+
+// Draw square (x, y) in the given LED matrix colour.
+void terminal_board_update(uint8_t x, uint8_t y, PixelColour colour);
+
+// Called after a batch of updates. Restores the normal display attributes
+// so other terminal output isn't coloured.
+void terminal_board_end_frame(void);
+
+#endif /* TERMINAL_BOARD_H_ */
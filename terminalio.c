@@ -8,42 +8,93 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <avr/pgmspace.h>
+#include "serialio.h"
+#include "format.h"
+
+
+// Escape sequences are kept in program memory. Sequences with numbers in
+// them are built from the CSI prefix with the format functions (see
+// format.h) rather than printf. Each sequence is sent with a single
+// serial_write() so that it is never cut off part way through if serial
+// output is being discarded (see serialio.h).
+static const char csi[] PROGMEM = "\x1b[";
+static const char normal_display_sequence[] PROGMEM = "\x1b[0m";
+static const char reverse_video_sequence[] PROGMEM = "\x1b[7m";
+static const char clear_terminal_sequence[] PROGMEM = "\x1b[2J";
+static const char clear_to_end_of_line_sequence[] PROGMEM = "\x1b[K";
+static const char hide_cursor_sequence[] PROGMEM = "\x1b[?25l";
+static const char show_cursor_sequence[] PROGMEM = "\x1b[?25h";
+static const char whole_display_scroll_sequence[] PROGMEM = "\x1b[r";
+static const char scroll_down_sequence[] PROGMEM = "\x1bM";	// ESC-M
+static const char scroll_up_sequence[] PROGMEM = "\x1b\x44";	// ESC-D
+
+static void write_sequence_P(const char* sequence) {
+	char buf[TERMINAL_MAX_SEQUENCE];
+	uint8_t len = format_string_P(buf, 0, sequence);
+	serial_write(buf, len);
+}
+
+uint8_t terminal_format_cursor_move(char* buf, uint8_t pos, uint8_t x, uint8_t y) {
+	pos = format_string_P(buf, pos, csi);
+	pos = format_uint(buf, pos, y, 1);
+	buf[pos++] = ';';
+	pos = format_uint(buf, pos, x, 1);
+	buf[pos++] = 'H';
+	return pos;
+}
 
+uint8_t terminal_format_cursor_forward(char* buf, uint8_t pos, uint8_t n) {
+	pos = format_string_P(buf, pos, csi);
+	pos = format_uint(buf, pos, n, 1);
+	buf[pos++] = 'C';
+	return pos;
+}
+
+uint8_t terminal_format_attribute(char* buf, uint8_t pos, DisplayParameter parameter) {
+	pos = format_string_P(buf, pos, csi);
+	pos = format_uint(buf, pos, parameter, 1);
+	buf[pos++] = 'm';
+	return pos;
+}
 
 void move_terminal_cursor(int x, int y) {
-    printf_P(PSTR("\x1b[%d;%dH"), y, x);
+	char buf[TERMINAL_MAX_SEQUENCE];
+	uint8_t len = terminal_format_cursor_move(buf, 0, x, y);
+	serial_write(buf, len);
 }
 
 void normal_display_mode(void) {
-	printf_P(PSTR("\x1b[0m"));
+	write_sequence_P(normal_display_sequence);
 }
 
 void reverse_video(void) {
-	printf_P(PSTR("\x1b[7m"));
+	write_sequence_P(reverse_video_sequence);
 }
 
 void clear_terminal(void) {
-	printf_P(PSTR("\x1b[2J"));
+	write_sequence_P(clear_terminal_sequence);
 }
 
 void clear_to_end_of_line(void) {
-	printf_P(PSTR("\x1b[K"));
+	write_sequence_P(clear_to_end_of_line_sequence);
 }
 
 void set_display_attribute(DisplayParameter parameter) {
-	printf_P(PSTR("\x1b[%dm"), parameter);
+	char buf[TERMINAL_MAX_SEQUENCE];
+	uint8_t len = terminal_format_attribute(buf, 0, parameter);
+	serial_write(buf, len);
 }
 
 void hide_cursor() {
-	printf_P(PSTR("\x1b[?25l"));
+	write_sequence_P(hide_cursor_sequence);
 }
 
 void show_cursor() {
-	printf_P(PSTR("\x1b[?25h"));
+	write_sequence_P(show_cursor_sequence);
 }
 
 void enable_scrolling_for_whole_display(void) {
-	printf_P(PSTR("\x1b[r"));
+	write_sequence_P(whole_display_scroll_sequence);
 }
 
 void set_scroll_region(int8_t y1, int8_t y2) {
@@ -51,11 +102,11 @@ void set_scroll_region(int8_t y1, int8_t y2) {
 }
 
 void scroll_down(void) {
-	printf_P(PSTR("\x1bM"));	// ESC-M
+	write_sequence_P(scroll_down_sequence);
 }
 
 void scroll_up(void) {
-	printf_P(PSTR("\x1b\x44"));	// ESC-D
+	write_sequence_P(scroll_up_sequence);
 }
 
 void draw_horizontal_line(int8_t y, int8_t start_x, int8_t end_x) {
@@ -56,6 +56,17 @@ typedef enum {
 } DisplayParameter;
 
 void move_terminal_cursor(int x, int y);
+
+// Build escape sequences for the cursor position, moving the cursor
+// forward n columns and setting a display attribute, without sending them.
+// Each appends the sequence to buf at position pos and returns the
+// position after it (see format.h). No sequence is longer than
+// TERMINAL_MAX_SEQUENCE characters.
+#define TERMINAL_MAX_SEQUENCE 10
+uint8_t terminal_format_cursor_move(char* buf, uint8_t pos, uint8_t x, uint8_t y);
+uint8_t terminal_format_cursor_forward(char* buf, uint8_t pos, uint8_t n);
+uint8_t terminal_format_attribute(char* buf, uint8_t pos, DisplayParameter parameter);
+
 void normal_display_mode(void);
 void reverse_video(void);
 void clear_terminal(void);
@@ -9,6 +9,8 @@
  */
 
 #include "timer0.h"
+#include "buttons.h"
+#include "countdown.h"
 #include <avr/io.h>
 #include <avr/interrupt.h>
 
@@ -55,24 +57,54 @@ void init_timer0(void) {
 	TIFR0 &= (1<<OCF0A);
 }
 
-uint32_t get_current_time(void) {
-	uint32_t returnValue;
+/* Read the tick count without turning interrupts off, so the main loop
+ * never delays the timer (or any other) interrupt. The count is read
+ * twice and the read is tried again if the two differ, which means the
+ * interrupt handler changed it (possibly half way through one of the
+ * reads). If timer_count isn't 0 the timer counter, read between the two
+ * reads of the tick count, is returned in it.
+ */
+static uint32_t read_ticks(uint8_t* timer_count) {
+	uint32_t ticks;
+	uint8_t count;
+	uint8_t tick_pending;
+	do {
+		ticks = clockTicks;
+		count = TCNT0;
+		tick_pending = bit_is_set(TIFR0, OCF0A);
+	} while (ticks != clockTicks);
 
-	/* Disable interrupts so we can be sure that the interrupt
-	 * doesn't fire when we've copied just a couple of bytes
-	 * of the value. Interrupts are re-enabled if they were
-	 * enabled at the start.
+	/* If interrupts are off (e.g. in an interrupt handler) the counter
+	 * may have been cleared without the tick being counted yet. (With
+	 * interrupts on, the handler would have changed the count.)
 	 */
-	uint8_t interruptsOn = bit_is_set(SREG, SREG_I);
-	cli();
-	returnValue = clockTicks;
-	if(interruptsOn) {
-		sei();
+	if (tick_pending && count < OCR0A) {
+		ticks++;
+	}
+	if (timer_count) {
+		*timer_count = count;
 	}
-	return returnValue;
+	return ticks;
+}
+
+uint32_t get_current_time(void) {
+	return read_ticks(0);
+}
+
+uint32_t get_current_time_us(void) {
+	uint8_t count;
+	uint32_t ticks = read_ticks(&count);
+	/* The counter counts every 8 microseconds (64 clock cycles) */
+	return ticks * 1000 + count * 8;
 }
 
 ISR(TIMER0_COMPA_vect) {
 	/* Increment our clock tick count */
 	clockTicks++;
+	
+	/* Debounce the push buttons */
+	sample_buttons(clockTicks);
+
+	/* Count down the game clocks */
+	countdown_tick();
 }
@@ -31,5 +31,13 @@ void init_timer0(void);
  */
 uint32_t get_current_time(void);
 
+/* Return the time in microseconds since the timer was initialised, to the
+ * nearest 8 microseconds. Wraps around every ~71 minutes, so only the
+ * difference between two times should be used. This is the time source
+ * for profiling and measuring latency. Like get_current_time() it never
+ * turns interrupts off.
+ */
+uint32_t get_current_time_us(void);
+
 
 #endif
\ No newline at end of file
@@ -0,0 +1,100 @@
+/*
+ * uart1.c
+ *
+ * Author: Arjun Srikanth
+ *
+ * Both buffers work like those in serialio.c - the interrupt handlers and
+ * the main program each only change their own position in each buffer, so
+ * interrupts never need to be turned off.
+ */
+
+#include "uart1.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include "memory.h"
+
+#define SYSCLK 8000000L
+
+#define BUFFER_MASK (UART1_BUFFER_SIZE - 1)
+#if (UART1_BUFFER_SIZE & BUFFER_MASK) != 0 || UART1_BUFFER_SIZE > 256
+#error "UART1_BUFFER_SIZE must be a power of two no larger than 256"
+#endif
+
+static volatile uint8_t rx_buffer[UART1_BUFFER_SIZE];
+static volatile uint8_t rx_head;
+static volatile uint8_t rx_tail;
+
+static volatile uint8_t tx_buffer[UART1_BUFFER_SIZE];
+static volatile uint8_t tx_head;
+static volatile uint8_t tx_tail;
+
+void init_uart1(long baudrate) {
+	rx_head = rx_tail = 0;
+	tx_head = tx_tail = 0;
+	memory_register(PSTR("link port buffers"),
+			sizeof(rx_buffer) + sizeof(tx_buffer));
+
+	// Rounded to the nearest UBRR value (as in serialio.c)
+	UBRR1 = ((SYSCLK / (8 * baudrate)) + 1)/2 - 1;
+	UCSR1A = 0;
+	UCSR1C = (1<<UCSZ11)|(1<<UCSZ10);
+	UCSR1B = (1<<RXEN1)|(1<<TXEN1)|(1<<RXCIE1);
+}
+
+uint8_t uart1_read(uint8_t* buf, uint8_t max) {
+	uint8_t head = rx_head;
+	uint8_t tail = rx_tail;
+	uint8_t count = 0;
+	while (tail != head && count < max) {
+		buf[count++] = rx_buffer[tail];
+		tail = (tail + 1) & BUFFER_MASK;
+	}
+	rx_tail = tail;
+	return count;
+}
+
+bool uart1_available(void) {
+	return rx_head != rx_tail;
+}
+
+void uart1_clear_input(void) {
+	rx_tail = rx_head;
+}
+
+void uart1_write(const uint8_t* buf, uint8_t len) {
+	for (uint8_t i = 0; i < len; i++) {
+		uint8_t head = tx_head;
+		uint8_t next = (head + 1) & BUFFER_MASK;
+		while (next == tx_tail) {
+			; // wait for the interrupt handler to make room
+		}
+		tx_buffer[head] = buf[i];
+		tx_head = next;
+		// Safe without turning interrupts off - see start_output() in serialio.c
+		UCSR1B |= (1<<UDRIE1);
+	}
+}
+
+ISR(USART1_UDRE_vect) {
+	uint8_t tail = tx_tail;
+	if (tail != tx_head) {
+		UDR1 = tx_buffer[tail];
+		tx_tail = (tail + 1) & BUFFER_MASK;
+	} else {
+		UCSR1B &= ~(1<<UDRIE1);
+	}
+}
+
+ISR(USART1_RX_vect) {
+	uint8_t byte = UDR1;
+	uint8_t head = rx_head;
+	uint8_t next = (head + 1) & BUFFER_MASK;
+	// If the buffer is full the byte is lost - the link sees a bad frame
+	if (next != rx_tail) {
+		rx_buffer[head] = byte;
+		rx_head = next;
+	}
+}
@@ -0,0 +1,38 @@
+/*
+ * uart1.h
+ *
+ * Author: Arjun Srikanth
+ *
+ * Interrupt driven binary IO on the second USART (RXD1 on pin D2, TXD1 on
+ * pin D3), used for the link between two units (see link.h). Unlike
+ * serialio there is no stdio stream and characters are never changed.
+ */
+
+
+#ifndef UART1_H_
+#define UART1_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Size of each of the receive and transmit buffers. Must be a power of
+// two no larger than 256 - each holds one less byte than its size.
+#define UART1_BUFFER_SIZE 64
+
+// Set up USART1 for the given baud rate, 8 data bits, no parity and 1
+// stop bit. Interrupts must be enabled globally for it to work.
+void init_uart1(long baudrate);
+
+// Copy up to max received bytes to buf, returning how many were copied
+uint8_t uart1_read(uint8_t* buf, uint8_t max);
+
+// Returns true if received bytes are waiting to be read
+bool uart1_available(void);
+
+// Discard any received bytes waiting to be read
+void uart1_clear_input(void);
+
+// Send len bytes, waiting for room in the transmit buffer if necessary
+void uart1_write(const uint8_t* buf, uint8_t len);
+
+#endif /* UART1_H_ */